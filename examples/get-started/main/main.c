@@ -3,6 +3,7 @@
 #include "freertos/task.h"
 #include "sdkconfig.h"
 #include "tm1638.h"
+#include "tm1668_seg7.h"
 
 #if CONFIG_IDF_TARGET_ESP32
 #define CLK_IO_PIN GPIO_NUM_18
@@ -16,19 +17,6 @@
 
 static const char TAG[] = "app_main";
 
-static const uint8_t num7seg[] = {
-    0b00111111, /* 0 */
-    0b00000110, /* 1 */
-    0b01011011, /* 2 */
-    0b01001111, /* 3 */
-    0b01100110, /* 4 */
-    0b01101101, /* 5 */
-    0b01111101, /* 6 */
-    0b00000111, /* 7 */
-    0b01111111, /* 8 */
-    0b01101111, /* 9 */
-};
-
 void app_main(void)
 {
     ESP_LOGI(TAG, "start");
@@ -42,9 +30,10 @@ void app_main(void)
     ESP_ERROR_CHECK(tm1638_new_device(&config, &handle));
 
     ESP_ERROR_CHECK(tm1638_reset(handle));
-    uint8_t buf[TM1638_DISPLAY_SIZE] = {
-        num7seg[1], 0, num7seg[2], 0, num7seg[3], 0, num7seg[4], 0,
-        num7seg[5], 0, num7seg[6], 0, num7seg[7], 0, num7seg[8], 0};
+    /* "12345678" on the eight digits (even addresses), LEDs (odd) off. */
+    uint8_t buf[TM1638_DISPLAY_SIZE] = {0};
+    const tm1668_seg7_format_t fmt = {.width = 8, .stride = 2};
+    ESP_ERROR_CHECK(tm1668_seg7_dec(&fmt, 12345678, buf));
     ESP_ERROR_CHECK(tm1638_display_auto(handle, 0, buf, sizeof(buf)));
     ESP_ERROR_CHECK(tm1638_set_pulse(handle, TM1638_PULSE_WIDTH_DEFAULT));
     ESP_ERROR_CHECK(tm1638_display(handle, true));
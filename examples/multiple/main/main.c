@@ -3,6 +3,7 @@
 #include "freertos/task.h"
 #include "sdkconfig.h"
 #include "tm1638.h"
+#include "tm1668_reflex.h"
 
 #if CONFIG_IDF_TARGET_ESP32
 #define CLK_IO_PIN GPIO_NUM_18
@@ -35,6 +36,24 @@ static const uint8_t num7seg[] = {
     0b01101111, /* 9 */
 };
 
+/* TM1668: K1 of KS1–KS5 lights address 6, K2 lights address 8, bits 0–4 */
+static const tm1668_reflex_t tm1668_leds[] = {
+    {0, 0, 6, 0}, {1, 0, 6, 1}, {2, 0, 6, 2}, {3, 0, 6, 3}, {4, 0, 6, 4},
+    {0, 3, 8, 0}, {1, 3, 8, 1}, {2, 3, 8, 2}, {3, 3, 8, 3}, {4, 3, 8, 4},
+};
+
+/* TM1638: key byte n lights the LEDs at address 2n + 1 (bits 0–2) and
+ * 2n + 9 (bits 4–6, shifted down) */
+#define TM1638_LEDS(n)                                                         \
+    {n, 0, 2 * n + 1, 0}, {n, 1, 2 * n + 1, 1}, {n, 2, 2 * n + 1, 2},          \
+        {n, 4, 2 * n + 9, 0}, {n, 5, 2 * n + 9, 1}, {n, 6, 2 * n + 9, 2}
+static const tm1668_reflex_t tm1638_leds[] = {
+    TM1638_LEDS(0),
+    TM1638_LEDS(1),
+    TM1638_LEDS(2),
+    TM1638_LEDS(3),
+};
+
 void app_main(void)
 {
     ESP_LOGI(TAG, "start");
@@ -52,7 +71,7 @@ void app_main(void)
     };
     tm1668_dev_handle_t tm1668_handle;
     ESP_ERROR_CHECK(
-        tm1638_bus_add_device(bus_handle, &tm1668_config, &tm1668_handle));
+        tm1668_bus_add_device(bus_handle, &tm1668_config, &tm1668_handle));
 
     const tm1638_device_config_t tm1638_config = {
         .stb_io_num = TM1638_STB_IO_PIN,
@@ -82,27 +101,15 @@ void app_main(void)
     ESP_ERROR_CHECK(tm1668_display(tm1668_handle, true));
     ESP_ERROR_CHECK(tm1638_display(tm1638_handle, true));
 
-    uint8_t key1[TM1668_KEY_SIZE];
-    uint8_t key2[TM1638_KEY_SIZE];
+    /* Key feedback is applied inside each scan of tm1668_bus_tick(). */
+    ESP_ERROR_CHECK(tm1668_set_reflex(tm1668_handle, tm1668_leds,
+                                      sizeof(tm1668_leds) /
+                                          sizeof(tm1668_leds[0])));
+    ESP_ERROR_CHECK(tm1668_set_reflex(tm1638_handle, tm1638_leds,
+                                      sizeof(tm1638_leds) /
+                                          sizeof(tm1638_leds[0])));
     while (1) {
-        ESP_ERROR_CHECK(tm1668_read_key(tm1668_handle, key1, sizeof(key1)));
-        uint8_t buf = 0;
-        for (int i = 0; i < TM1668_KEY_SIZE; i++) {
-            buf |= (key1[i] & 1) << i;
-        }
-        ESP_ERROR_CHECK(tm1668_display_fixed(tm1668_handle, 6, buf));
-        buf = 0;
-        for (int i = 0; i < TM1668_KEY_SIZE; i++) {
-            buf |= ((key1[i] >> 3) & 1) << i;
-        }
-        ESP_ERROR_CHECK(tm1668_display_fixed(tm1668_handle, 8, buf));
-        ESP_ERROR_CHECK(tm1638_read_key(tm1638_handle, key2, sizeof(key2)));
-        for (int i = 0; i < TM1638_KEY_SIZE * 2; i++) {
-            ESP_ERROR_CHECK(tm1638_display_fixed(
-                tm1638_handle, i * 2 + 1,
-                i < TM1638_KEY_SIZE ? key2[i % TM1638_KEY_SIZE]
-                                    : key2[i % TM1638_KEY_SIZE] >> 4));
-        }
-        vTaskDelay(pdMS_TO_TICKS(50));
+        ESP_ERROR_CHECK(tm1668_bus_tick(bus_handle));
+        vTaskDelay(pdMS_TO_TICKS(10));
     }
 }
@@ -29,6 +29,12 @@ typedef tm1668_bus_handle_t tm1638_bus_handle_t;
 
 /** Alias for tm1668_device_config_t — per-device configuration on a bus. */
 typedef tm1668_device_config_t tm1638_device_config_t;
+
+/** Alias for tm1668_bus_static_t — caller-provided bus storage. */
+typedef tm1668_bus_static_t tm1638_bus_static_t;
+
+/** Alias for tm1668_dev_static_t — caller-provided device storage. */
+typedef tm1668_dev_static_t tm1638_dev_static_t;
 #endif // CONFIG_TM1668_WITH_BUS
 
 /** Alias for tm1668_dev_handle_t — opaque device handle. */
@@ -52,14 +58,53 @@ static inline esp_err_t tm1638_new_bus(const tm1638_bus_config_t *bus_config,
 /**
  * @brief Add a TM1638 device to a shared bus.
  *
- * Equivalent to tm1668_bus_add_device().
+ * Equivalent to tm1668_bus_add_device() with flags.tm1638 set.
  */
 static inline esp_err_t
 tm1638_bus_add_device(tm1638_bus_handle_t bus_handle,
                       const tm1638_device_config_t *dev_config,
                       tm1638_dev_handle_t *ret_handle)
 {
-    return tm1668_bus_add_device(bus_handle, dev_config, ret_handle);
+    tm1638_device_config_t config;
+    if (dev_config) {
+        config = *dev_config;
+        config.flags.tm1638 = 1;
+    }
+    return tm1668_bus_add_device(bus_handle, dev_config ? &config : NULL,
+                                 ret_handle);
+}
+
+/**
+ * @brief Create a new shared bus for TM1638 devices in caller storage.
+ *
+ * Equivalent to tm1668_new_bus_static().
+ */
+static inline esp_err_t
+tm1638_new_bus_static(const tm1638_bus_config_t *bus_config,
+                      tm1638_bus_static_t *bus_buffer,
+                      tm1638_bus_handle_t *ret_bus_handle)
+{
+    return tm1668_new_bus_static(bus_config, bus_buffer, ret_bus_handle);
+}
+
+/**
+ * @brief Add a TM1638 device to a shared bus using caller storage.
+ *
+ * Equivalent to tm1668_bus_add_device_static() with flags.tm1638 set.
+ */
+static inline esp_err_t
+tm1638_bus_add_device_static(tm1638_bus_handle_t bus_handle,
+                             const tm1638_device_config_t *dev_config,
+                             tm1638_dev_static_t *dev_buffer,
+                             tm1638_dev_handle_t *ret_handle)
+{
+    tm1638_device_config_t config;
+    if (dev_config) {
+        config = *dev_config;
+        config.flags.tm1638 = 1;
+    }
+    return tm1668_bus_add_device_static(
+        bus_handle, dev_config ? &config : NULL, dev_buffer, ret_handle);
 }
 
 /**
@@ -92,17 +137,34 @@ static inline esp_err_t tm1638_get_bus(tm1668_dev_handle_t handle,
 {
     return tm1668_get_bus(handle, ret_bus_handle);
 }
+
+/**
+ * @brief Service every TM1638 device on the bus in one pass.
+ *
+ * Equivalent to tm1668_bus_tick(). Devices added with the tm1638_*
+ * wrappers are scanned for TM1638_KEY_SIZE bytes; the last byte of their
+ * key cache stays 0.
+ */
+static inline esp_err_t tm1638_bus_tick(tm1638_bus_handle_t bus_handle)
+{
+    return tm1668_bus_tick(bus_handle);
+}
 #endif // CONFIG_TM1668_WITH_BUS
 
 /**
  * @brief Create a new TM1638 device (standalone mode).
  *
- * Equivalent to tm1668_new_device().
+ * Equivalent to tm1668_new_device() with flags.tm1638 set.
  */
 static inline esp_err_t tm1638_new_device(const tm1668_config_t *config,
                                           tm1668_dev_handle_t *ret_handle)
 {
-    return tm1668_new_device(config, ret_handle);
+    tm1668_config_t tm1638_config;
+    if (config) {
+        tm1638_config = *config;
+        tm1638_config.flags.tm1638 = 1;
+    }
+    return tm1668_new_device(config ? &tm1638_config : NULL, ret_handle);
 }
 
 /**
@@ -169,6 +231,67 @@ static inline esp_err_t tm1638_display_fixed(tm1638_dev_handle_t handle,
     return tm1668_display_fixed(handle, address, data);
 }
 
+/**
+ * @brief Stage display data without sending it (TM1638).
+ *
+ * Equivalent to tm1668_display_buffer().
+ */
+static inline esp_err_t tm1638_display_buffer(tm1638_dev_handle_t handle,
+                                              uint8_t address,
+                                              const uint8_t *data, size_t size)
+{
+    return tm1668_display_buffer(handle, address, data, size);
+}
+
+/**
+ * @brief Stage a single segment without sending it (TM1638).
+ *
+ * Equivalent to tm1668_set_segment(); TM1638 grids have SEG1–SEG10
+ * (seg 0–9).
+ */
+static inline esp_err_t tm1638_set_segment(tm1638_dev_handle_t handle,
+                                           uint8_t grid, uint8_t seg, bool on)
+{
+    return tm1668_set_segment(handle, grid, seg, on);
+}
+
+/**
+ * @brief Stage one of the discrete LEDs of a TM1638 LED&KEY style board.
+ *
+ * These boards wire LED n (0–7) to SEG9 of GRID(n + 1), i.e. bit 0 of the
+ * odd display address 2n + 1. Send with tm1638_flush().
+ *
+ * @param[in] handle Device handle.
+ * @param[in] led    LED index (0–7).
+ * @param[in] on     Light (true) or clear (false) the LED.
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG.
+ */
+static inline esp_err_t tm1638_set_led(tm1638_dev_handle_t handle, uint8_t led,
+                                       bool on)
+{
+    return tm1668_set_segment(handle, led, 8, on);
+}
+
+/**
+ * @brief Send the pending display data (TM1638).
+ *
+ * Equivalent to tm1668_flush().
+ */
+static inline esp_err_t tm1638_flush(tm1638_dev_handle_t handle)
+{
+    return tm1668_flush(handle);
+}
+
+/**
+ * @brief Restore the whole chip state after a chip reset (TM1638).
+ *
+ * Equivalent to tm1668_resync().
+ */
+static inline esp_err_t tm1638_resync(tm1638_dev_handle_t handle)
+{
+    return tm1668_resync(handle);
+}
+
 /**
  * @brief TM1638 keypad scan data layout (4 bytes).
  *
@@ -196,6 +319,29 @@ static inline esp_err_t tm1638_read_key(tm1638_dev_handle_t handle,
     return tm1668_read_key(handle, data, size);
 }
 
+/**
+ * @brief Get the last key scan result (TM1638).
+ *
+ * Equivalent to tm1668_get_key().
+ */
+static inline esp_err_t tm1638_get_key(tm1638_dev_handle_t handle,
+                                       uint8_t *data, size_t size)
+{
+    return tm1668_get_key(handle, data, size);
+}
+
+/**
+ * @brief Get the debounced key state and key edges (TM1638).
+ *
+ * Equivalent to tm1668_get_keys().
+ */
+static inline esp_err_t tm1638_get_keys(tm1638_dev_handle_t handle,
+                                        uint8_t *state, uint8_t *pressed,
+                                        uint8_t *released, size_t size)
+{
+    return tm1668_get_keys(handle, state, pressed, released, size);
+}
+
 /**
  * @note The TM1638 does NOT support tm1638_set_mode(). The display mode
  *       is fixed at 8 grids × 10 segments. tm1668_set_mode() is not
@@ -242,3 +388,33 @@ static inline esp_err_t tm1638_display(tm1638_dev_handle_t handle, bool value)
 {
     return tm1668_display(handle, value);
 }
+
+/** Alias for tm1668_timing_t — per-bus serial timing. */
+typedef tm1668_timing_t tm1638_timing_t;
+
+/** Alias for tm1668_calibrate_config_t — calibration settings. */
+typedef tm1668_calibrate_config_t tm1638_calibrate_config_t;
+
+/**
+ * @brief Set the serial timing of the bus (TM1638).
+ *
+ * Equivalent to tm1668_set_timing().
+ */
+static inline esp_err_t tm1638_set_timing(tm1638_dev_handle_t handle,
+                                          const tm1638_timing_t *timing)
+{
+    return tm1668_set_timing(handle, timing);
+}
+
+/**
+ * @brief Find the fastest stable timing for the bus (TM1638).
+ *
+ * Equivalent to tm1668_calibrate().
+ */
+static inline esp_err_t
+tm1638_calibrate(tm1638_dev_handle_t handle,
+                 const tm1638_calibrate_config_t *config,
+                 tm1638_timing_t *ret_timing)
+{
+    return tm1668_calibrate(handle, config, ret_timing);
+}
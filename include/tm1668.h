@@ -32,9 +32,11 @@
 #pragma once
 
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
 #include "hal/gpio_types.h"
 #include "sdkconfig.h"
 #include <stdbool.h>
+#include <string.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -54,6 +56,12 @@ typedef struct {
     struct {
         uint32_t enable_internal_pullup
             : 1; /**< Enable internal pull-up on CLK and DIO */
+        uint32_t defer_gpio_init
+            : 1; /**< Leave CLK, DIO and every STB GPIO unconfigured until
+                      tm1668_bus_init_all() sets them up together */
+        uint32_t dio_push_pull
+            : 1; /**< Drive DIO push-pull while writing; open-drain only
+                      during key reads */
     } flags;
 } tm1668_bus_config_t;
 
@@ -72,8 +80,45 @@ typedef struct {
     struct {
         uint32_t enable_internal_pullup
             : 1; /**< Enable internal pull-up on STB */
+        uint32_t tm1638 : 1; /**< The chip is a TM1638: key scans are
+                                  TM1638_KEY_SIZE bytes (set by the
+                                  tm1638_* wrappers) */
     } flags;
 } tm1668_device_config_t;
+
+/** Pointer-sized words reserved in tm1668_bus_static_t. */
+#define TM1668_BUS_STATIC_WORDS 13
+
+/** Pointer-sized words reserved in tm1668_dev_static_t. */
+#ifdef CONFIG_TM1668_LATENCY
+#define TM1668_DEV_STATIC_WORDS (30 + 32)
+#else
+#define TM1668_DEV_STATIC_WORDS 30
+#endif
+
+/**
+ * @brief Caller-provided storage for a bus (see tm1668_new_bus_static()).
+ *
+ * The contents are private to the driver; only the size and alignment
+ * matter. The storage must stay valid until tm1668_del_bus() returns.
+ */
+typedef struct {
+    StaticSemaphore_t _lock;                  /**< Reserved */
+    uint64_t _align;                          /**< Reserved */
+    void *_reserved[TM1668_BUS_STATIC_WORDS]; /**< Reserved */
+} tm1668_bus_static_t;
+
+/**
+ * @brief Caller-provided storage for a device (see
+ * tm1668_bus_add_device_static()).
+ *
+ * The contents are private to the driver; only the size and alignment
+ * matter. The storage must stay valid until the device is removed.
+ */
+typedef struct {
+    uint64_t _align;                          /**< Reserved */
+    void *_reserved[TM1668_DEV_STATIC_WORDS]; /**< Reserved */
+} tm1668_dev_static_t;
 #endif // CONFIG_TM1668_WITH_BUS
 
 /** Opaque handle for a single TM1668 device. */
@@ -93,6 +138,12 @@ typedef struct {
     struct {
         uint32_t enable_internal_pullup
             : 1; /**< Enable internal pull-up on all three pins */
+        uint32_t dio_push_pull
+            : 1; /**< Drive DIO push-pull while writing; open-drain only
+                      during key reads */
+        uint32_t tm1638 : 1; /**< The chip is a TM1638: key scans are
+                                  TM1638_KEY_SIZE bytes (set by the
+                                  tm1638_* wrappers) */
     } flags;
 } tm1668_config_t;
 
@@ -113,6 +164,23 @@ typedef struct {
 esp_err_t tm1668_new_bus(const tm1668_bus_config_t *bus_config,
                          tm1668_bus_handle_t *ret_bus_handle);
 
+/**
+ * @brief Create a new shared bus in caller-provided storage.
+ *
+ * Same as tm1668_new_bus() but performs no heap allocation; the bus
+ * structure and its semaphore live in `bus_buffer`.
+ *
+ * @param[in]  bus_config     Pointer to bus configuration structure.
+ * @param[in]  bus_buffer     Storage for the bus (e.g. a static variable).
+ * @param[out] ret_bus_handle Pointer to receive the new bus handle.
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if an argument is NULL or pin numbers are invalid.
+ */
+esp_err_t tm1668_new_bus_static(const tm1668_bus_config_t *bus_config,
+                                tm1668_bus_static_t *bus_buffer,
+                                tm1668_bus_handle_t *ret_bus_handle);
+
 /**
  * @brief Add a device to an existing shared bus.
  *
@@ -131,10 +199,33 @@ esp_err_t tm1668_bus_add_device(tm1668_bus_handle_t bus_handle,
                                 const tm1668_device_config_t *dev_config,
                                 tm1668_dev_handle_t *ret_handle);
 
+/**
+ * @brief Add a device to a shared bus using caller-provided storage.
+ *
+ * Same as tm1668_bus_add_device() but performs no heap allocation. The
+ * device is linked into the bus through an entry embedded in its own
+ * structure, and the STB uniqueness check is a constant-time bitmask test.
+ *
+ * @param[in]  bus_handle  Bus handle created by tm1668_new_bus() or
+ *                         tm1668_new_bus_static().
+ * @param[in]  dev_config  Pointer to device configuration.
+ * @param[in]  dev_buffer  Storage for the device (e.g. a static variable).
+ * @param[out] ret_handle  Pointer to receive the new device handle.
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if arguments are invalid or STB pin already in use.
+ */
+esp_err_t tm1668_bus_add_device_static(tm1668_bus_handle_t bus_handle,
+                                       const tm1668_device_config_t *dev_config,
+                                       tm1668_dev_static_t *dev_buffer,
+                                       tm1668_dev_handle_t *ret_handle);
+
 /**
  * @brief Delete a bus and free associated resources.
  *
- * The semaphore and bus memory are freed. 
+ * The semaphore and bus memory are freed. Storage passed to
+ * tm1668_new_bus_static() or tm1668_bus_add_device_static() is left to
+ * the caller.
  *
  * @param[in] bus_handle Bus handle to delete.
  * @return
@@ -147,7 +238,8 @@ esp_err_t tm1668_del_bus(tm1668_bus_handle_t bus_handle);
  * @brief Remove a device from its bus and free the device handle.
  *
  * Removes the device from the bus's device list and frees the device
- * memory. Does not affect other devices on the same bus.
+ * memory (unless it was added with tm1668_bus_add_device_static()).
+ * Does not affect other devices on the same bus.
  *
  * @param[in] handle Device handle to remove.
  * @return
@@ -168,6 +260,85 @@ esp_err_t tm1668_bus_rm_device(tm1668_dev_handle_t handle);
 esp_err_t tm1668_get_bus(tm1668_dev_handle_t handle,
                          tm1668_bus_handle_t *ret_bus_handle);
 
+/**
+ * @brief Service every device on the bus in one pass.
+ *
+ * Visits the devices in the order they were added. For each device, the
+ * display bytes staged with tm1668_display_buffer() are sent as in
+ * tm1668_flush(), then the device's key bytes — TM1668_KEY_SIZE, or
+ * TM1638_KEY_SIZE for a TM1638 — are read into its key cache (see
+ * tm1668_get_key()). The bus is held for the whole
+ * pass, so the bus occupancy of one tick only depends on the number of
+ * devices and the amount of pending display data.
+ *
+ * @param[in] bus_handle Bus handle.
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if bus_handle is NULL.
+ */
+esp_err_t tm1668_bus_tick(tm1668_bus_handle_t bus_handle);
+
+/**
+ * @brief Bring-up settings applied by tm1668_bus_init_all().
+ */
+typedef struct {
+    uint8_t mode;        /**< Display mode, used if flags.set_mode */
+    uint8_t pulse_width; /**< Pulse width (TM1668_PULSE_WIDTH_*) */
+    struct {
+        uint32_t set_mode : 1;   /**< Send `mode` to every device. Leave
+                                      clear on buses with TM1638s. */
+        uint32_t display_on : 1; /**< Turn the displays on */
+    } flags;
+} tm1668_bus_init_config_t;
+
+/**
+ * @brief Cold-start every device on the bus at once.
+ *
+ * Configures the GPIOs of the bus and of every attached device with one
+ * gpio_config() call per pin mode, instead of one per pin. Then, with
+ * every STB line low together, it sends one frame each for the display
+ * mode (optional), the data command (auto-increment), a blank display RAM
+ * and the display control. The bring-up cost is four frames however many
+ * devices share the bus.
+ *
+ * The device shadows are cleared to match. Combine with
+ * flags.defer_gpio_init in tm1668_bus_config_t so that tm1668_new_bus()
+ * and tm1668_bus_add_device() do no per-pin GPIO setup. Devices must not
+ * be used before this call in that case.
+ *
+ * @param[in] bus_handle  Bus handle.
+ * @param[in] init_config Bring-up settings.
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if an argument is NULL.
+ *  - The underlying GPIO error code if the pins cannot be configured.
+ */
+esp_err_t tm1668_bus_init_all(tm1668_bus_handle_t bus_handle,
+                              const tm1668_bus_init_config_t *init_config);
+
+/**
+ * @brief Get the debounced keys of every device on the bus.
+ *
+ * Same as tm1668_get_keys() for each device, in the order they were added;
+ * device i fills bytes [i × TM1668_KEY_SIZE, (i + 1) × TM1668_KEY_SIZE)
+ * of each buffer. Pair with tm1668_bus_tick() to scan and debounce a whole
+ * bus per frame.
+ *
+ * @param[in]  bus_handle Bus handle.
+ * @param[out] state      Debounced key state, or NULL.
+ * @param[out] pressed    Keys pressed since the last call, or NULL.
+ * @param[out] released   Keys released since the last call, or NULL.
+ * @param[in]  size       Bytes per buffer.
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if bus_handle is NULL.
+ *  - ESP_ERR_INVALID_SIZE if the buffers cannot hold every device; the
+ *    devices that fit are filled.
+ */
+esp_err_t tm1668_bus_get_keys(tm1668_bus_handle_t bus_handle, uint8_t *state,
+                              uint8_t *pressed, uint8_t *released,
+                              size_t size);
+
 /**
  * @brief Convenience macro to return early on ESP error.
  * @internal Used by the inline tm1668_new_device() and tm1668_del_device()
@@ -196,17 +367,23 @@ static inline esp_err_t tm1668_new_device(const tm1668_config_t *config,
                                           tm1668_dev_handle_t *ret_handle)
 {
     esp_err_t ret;
-    const tm1668_bus_config_t bus_config = {
-        .clk_io_num = config->clk_io_num,
-        .dio_io_num = config->dio_io_num,
-        .flags.enable_internal_pullup = config->flags.enable_internal_pullup,
-    };
+    /* Zeroed, then field by field: nested designators are not valid C++,
+     * and flags left out here must read as 0. */
+    tm1668_bus_config_t bus_config;
+    memset(&bus_config, 0, sizeof(bus_config));
+    bus_config.clk_io_num = config->clk_io_num;
+    bus_config.dio_io_num = config->dio_io_num;
+    bus_config.flags.enable_internal_pullup =
+        config->flags.enable_internal_pullup;
+    bus_config.flags.dio_push_pull = config->flags.dio_push_pull;
     tm1668_bus_handle_t bus_handle;
     _TM1668_CHECK_ESP_OK_(tm1668_new_bus(&bus_config, &bus_handle));
-    const tm1668_device_config_t dev_config = {
-        .stb_io_num = config->stb_io_num,
-        .flags.enable_internal_pullup = config->flags.enable_internal_pullup,
-    };
+    tm1668_device_config_t dev_config;
+    memset(&dev_config, 0, sizeof(dev_config));
+    dev_config.stb_io_num = config->stb_io_num;
+    dev_config.flags.enable_internal_pullup =
+        config->flags.enable_internal_pullup;
+    dev_config.flags.tm1638 = config->flags.tm1638;
     ret = tm1668_bus_add_device(bus_handle, &dev_config, ret_handle);
     if (ret != ESP_OK) {
         tm1668_del_bus(bus_handle);
@@ -321,6 +498,76 @@ esp_err_t tm1668_display_auto(tm1668_dev_handle_t handle, uint8_t address,
 esp_err_t tm1668_display_fixed(tm1668_dev_handle_t handle, uint8_t address,
                                uint8_t data);
 
+/**
+ * @brief Stage display data without sending it.
+ *
+ * Copies the bytes into the device's display shadow and marks those that
+ * changed as pending. Pending bytes are sent by tm1668_flush() or
+ * tm1668_bus_tick(). Safe to call from any task.
+ *
+ * @param[in] handle  Device handle.
+ * @param[in] address Starting display register address (0–15).
+ * @param[in] data    Pointer to the data buffer to stage.
+ * @param[in] size    Number of bytes (address + size must not exceed 16).
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t tm1668_display_buffer(tm1668_dev_handle_t handle, uint8_t address,
+                                const uint8_t *data, size_t size);
+
+/**
+ * @brief Stage a single segment (LED) without sending it.
+ *
+ * Sets or clears one bit of the display shadow. GRIDn (grid = n − 1) owns
+ * display addresses 2·(n − 1) for SEG1–SEG8 and 2·(n − 1) + 1 for
+ * SEG9–SEG16; SEGm is bit (m − 1) mod 8. The bit is sent by the next
+ * tm1668_flush() or tm1668_bus_tick(), together with every other segment
+ * changed in between, so a frame with many LED changes costs one burst.
+ *
+ * @param[in] handle Device handle.
+ * @param[in] grid   Zero-based grid index (0 = GRID1, 0–7).
+ * @param[in] seg    Zero-based segment index (0 = SEG1, 0–15).
+ * @param[in] on     Light (true) or clear (false) the segment.
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t tm1668_set_segment(tm1668_dev_handle_t handle, uint8_t grid,
+                             uint8_t seg, bool on);
+
+/**
+ * @brief Send the pending display data of a device.
+ *
+ * Pending bytes are sent in as few auto-increment transactions as
+ * possible: runs separated by a single unchanged byte are merged, wider
+ * gaps start a new transaction. Does nothing if nothing is pending.
+ *
+ * @param[in] handle Device handle.
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t tm1668_flush(tm1668_dev_handle_t handle);
+
+/**
+ * @brief Restore the whole chip state after a chip reset.
+ *
+ * Sends the cached display mode (if one was set), the data command, the
+ * whole display shadow as one burst and the cached display control, so a
+ * chip that lost power shows what the driver believes it shows.
+ *
+ * @param[in] handle Device handle.
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t tm1668_resync(tm1668_dev_handle_t handle);
+
+/**
+ * @brief Schedule tm1668_resync() for the next flush (ISR-safe).
+ *
+ * For an external reset indication, e.g. a power-good GPIO interrupt or a
+ * supervisor callback. The next tm1668_flush() or tm1668_bus_tick() of the
+ * device resyncs it instead of sending only the pending bytes. With
+ * CONFIG_TM1668_KEY_RESYNC, implausible key scans schedule it too.
+ *
+ * @param[in] handle Device handle.
+ */
+void tm1668_request_resync(tm1668_dev_handle_t handle);
+
 /**
  * @brief TM1668 keypad scan data layout (5 bytes).
  *
@@ -353,6 +600,47 @@ esp_err_t tm1668_display_fixed(tm1668_dev_handle_t handle, uint8_t address,
 esp_err_t tm1668_read_key(tm1668_dev_handle_t handle, uint8_t *data,
                           size_t size);
 
+/**
+ * @brief Get the last key scan result without touching the bus.
+ *
+ * Returns the bytes sampled by the most recent tm1668_read_key() or
+ * tm1668_bus_tick() on this device.
+ *
+ * @param[in]  handle Device handle.
+ * @param[out] data   Buffer to receive key data.
+ * @param[in]  size   Number of bytes (at most TM1668_KEY_SIZE).
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t tm1668_get_key(tm1668_dev_handle_t handle, uint8_t *data,
+                         size_t size);
+
+/** Consecutive scans a key must differ before its debounced state flips. */
+#define TM1668_DEBOUNCE_SCANS 4
+
+/**
+ * @brief Get the debounced key state and the key edges since the last call.
+ *
+ * Every key scan of the device (tm1668_read_key(), tm1668_bus_tick(), the
+ * multi-bus key read) feeds a debouncer that accepts a change of a key
+ * after TM1668_DEBOUNCE_SCANS scans in a row saw it, so the debounce time
+ * is that many scan periods. All keys are debounced together with
+ * bitwise vertical counters; there is no per-key state machine.
+ *
+ * Layout of each buffer is that of tm1668_read_key(). Press and release
+ * edges accumulate until read, so none are lost between calls.
+ *
+ * @param[in]  handle   Device handle.
+ * @param[out] state    Debounced key state, or NULL.
+ * @param[out] pressed  Keys pressed since the last call, or NULL (then
+ *                      the press edges are kept).
+ * @param[out] released Keys released since the last call, or NULL (then
+ *                      the release edges are kept).
+ * @param[in]  size     Bytes per buffer (at most TM1668_KEY_SIZE).
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t tm1668_get_keys(tm1668_dev_handle_t handle, uint8_t *state,
+                          uint8_t *pressed, uint8_t *released, size_t size);
+
 /** Display mode: number of grids × number of segments per grid. */
 enum {
     TM1668_MODE_4x13 = 0, /**< 4 grids, 13 segments each */
@@ -369,7 +657,12 @@ enum {
  *
  * TM1668 supports four modes with different grid/segment trade-offs
  * (see TM1668_MODE_* enum). TM1638 does NOT support this command;
- * it is fixed at 8 grids × 10 segments.
+ * it is fixed at 8 grids × 10 segments, so do not call it for a TM1638.
+ *
+ * The mode is recorded on the device. From then on, display writes skip
+ * the addresses that drive no grid in this mode (e.g. addresses 8–15 in
+ * 4 × 13 mode), and tm1668_set_segment() rejects segments the mode does
+ * not drive. Until the first call every address is sent.
  *
  * @param[in] handle Device handle.
  * @param[in] value  Display mode (TM1668_MODE_4x13 through TM1668_MODE_7x10).
@@ -418,6 +711,133 @@ esp_err_t tm1668_set_pulse(tm1668_dev_handle_t handle, uint8_t value);
  */
 esp_err_t tm1668_display(tm1668_dev_handle_t handle, bool value);
 
+/**
+ * @brief Serial timing of a bus, in microseconds.
+ *
+ * Every bus starts with CONFIG_TM1668_DELAY_US for both half-cycle delays,
+ * CONFIG_TM1668_READ_KEY_DELAY_US for the key settling delay and no extra
+ * STB setup or hold time.
+ */
+typedef struct {
+    uint16_t write_delay_us;    /**< CLK half-cycle while sending (1–1000) */
+    uint16_t read_delay_us;     /**< CLK half-cycle while reading keys (1–1000) */
+    uint16_t read_key_delay_us; /**< Delay after READ_KEY (1–1000) */
+    uint16_t stb_setup_us; /**< STB low to the first CLK edge (0–1000) */
+    uint16_t stb_hold_us;  /**< Last CLK edge to STB high (0–1000) */
+} tm1668_timing_t;
+
+/**
+ * @brief Get the serial timing of the bus a device is on.
+ *
+ * @param[in]  handle     Device handle.
+ * @param[out] ret_timing Receives the timing.
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t tm1668_get_timing(tm1668_dev_handle_t handle,
+                            tm1668_timing_t *ret_timing);
+
+/**
+ * @brief Set the serial timing of the bus a device is on.
+ *
+ * In bus mode the timing applies to every device sharing the bus.
+ *
+ * @param[in] handle Device handle.
+ * @param[in] timing New timing.
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG if a value is out of
+ *         range.
+ */
+esp_err_t tm1668_set_timing(tm1668_dev_handle_t handle,
+                            const tm1668_timing_t *timing);
+
+/**
+ * @brief Calibration settings, all optional (zero selects the default).
+ */
+typedef struct {
+    uint16_t max_delay_us; /**< Slowest half-cycle tried and used for the
+                                reference scan (default 4 ×
+                                CONFIG_TM1668_DELAY_US, at most 1000;
+                                lowered to 1000 − margin_us) */
+    uint16_t samples;      /**< Scans per candidate timing (default 16) */
+    uint16_t margin_us;    /**< Added to every value found (default 0,
+                                below 1000) */
+} tm1668_calibrate_config_t;
+
+/**
+ * @brief Find the fastest stable timing for the bus a device is on.
+ *
+ * Takes a reference key scan at the slowest timing, then tries half-cycle
+ * delays from 1 µs upwards and keeps the first one at which `samples`
+ * consecutive scans all match the reference, followed by the shortest
+ * stable READ_KEY settling delay. Bit 7 of every key byte, which is unused
+ * on both chips, must read 0. Writes cannot be read back, so the write
+ * delay is set to the read delay found. The result (plus the margin) is
+ * stored on the bus. The probe scans are bare frames: they do not update
+ * the key cache, debounced keys, reflex bindings or the latency tracer.
+ *
+ * With every key released the chip sends only zeros, so the scans can only
+ * catch a DIO that is not driven in time and reads 1 (e.g. a chip that
+ * missed a mis-clocked READ_KEY, or a slow pull-up), not bits sampled early
+ * or late. Holding one or more keys throughout the calibration gives a
+ * reference with ones and zeros, which catches those as well.
+ *
+ * Call at bring-up, before other tasks use the bus, with the keys left as
+ * they are for the whole calibration.
+ *
+ * @param[in]  handle     Device handle.
+ * @param[in]  config     Calibration settings, or NULL for the defaults.
+ * @param[out] ret_timing Receives the timing chosen, or NULL.
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if handle is NULL, margin_us is 1000 or more, or
+ *    max_delay_us is above 1000.
+ *  - ESP_ERR_INVALID_RESPONSE if the key data is not stable even at the
+ *    slowest timing (the previous timing is kept).
+ *  - ESP_ERR_INVALID_STATE if the timing found plus the margin is out of
+ *    range (the previous timing is kept).
+ */
+esp_err_t tm1668_calibrate(tm1668_dev_handle_t handle,
+                           const tm1668_calibrate_config_t *config,
+                           tm1668_timing_t *ret_timing);
+
+/**
+ * @brief Unchecked entry points.
+ *
+ * These perform the same bus transactions (and keep the same cached device
+ * state) as their checked counterparts, but skip argument validation and
+ * error logging. They are meant for callers that have already proved the
+ * arguments valid, such as the C++ wrapper in tm1668.hpp, which checks
+ * addresses and sizes at compile time. Passing invalid arguments is
+ * undefined behaviour.
+ * @{
+ */
+
+/** tm1668_display_auto() without argument checks. */
+void tm1668_display_auto_unchecked(tm1668_dev_handle_t handle, uint8_t address,
+                                   const uint8_t *data, size_t size);
+
+/** tm1668_display_fixed() without argument checks. */
+void tm1668_display_fixed_unchecked(tm1668_dev_handle_t handle,
+                                    uint8_t address, uint8_t data);
+
+/** tm1668_read_key() without argument checks. */
+void tm1668_read_key_unchecked(tm1668_dev_handle_t handle, uint8_t *data,
+                               size_t size);
+
+/**
+ * @brief Send a pre-encoded display mode, data or display control command.
+ *
+ * The cached device state (display mode and the addresses it drives,
+ * address mode, display on/off, pulse width) is updated from the command
+ * byte, so later checked calls, flushes and resyncs stay consistent.
+ * Must not be used for READ_KEY or address commands.
+ *
+ * @param[in] handle  Device handle.
+ * @param[in] command Encoded command byte.
+ */
+void tm1668_command_unchecked(tm1668_dev_handle_t handle, uint8_t command);
+
+/** @} */
+
 #ifdef __cplusplus
 }
 #endif
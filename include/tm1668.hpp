@@ -0,0 +1,436 @@
+/**
+ * @file tm1668.hpp
+ * @brief Header-only C++17 wrapper for the TM1668/TM1638 driver.
+ *
+ * Provides RAII `Bus` and `Device<Chip>` classes on top of the C API.
+ * The chip traits (`TM1668`, `TM1638`) carry the display and key buffer
+ * sizes and whether the display-mode command exists, so that:
+ *
+ * - frames and key buffers are fixed-size `std::array`s of the right size;
+ * - display addresses given as template arguments are bounds-checked at
+ *   compile time;
+ * - `set_mode()` does not compile for a TM1638;
+ * - command bytes are encoded with `constexpr` functions;
+ * - board wiring remaps are compiled at compile time by make_remap().
+ *
+ * Calls whose arguments are proved valid at compile time go through the
+ * tm1668_*_unchecked() entry points and therefore skip the runtime argument
+ * checks and error logging of the C API. Calls with runtime addresses use
+ * the checked C functions and return their esp_err_t.
+ *
+ * @code{.cpp}
+ * tm1668::Device<tm1668::TM1638> dev(config);
+ * if (!dev) { return; }
+ * dev.reset();
+ * dev.write(tm1668::Device<tm1668::TM1638>::Frame{});
+ * dev.write_fixed<1>(0xFF);
+ * dev.set_pulse(tm1668::Pulse::Width4);
+ * dev.display(true);
+ * auto keys = dev.read_key();
+ * @endcode
+ */
+
+#pragma once
+
+#include "tm1638.h"
+#include "tm1668.h"
+#include "tm1668_cost.h"
+#include "tm1668_reflex.h"
+#include "tm1668_remap.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace tm1668 {
+
+/** Constexpr encoding of the command bytes (TM1668 / TM1638 datasheet). */
+namespace command {
+
+/** Display mode setting command: 0b000000MM. */
+constexpr uint8_t mode(uint8_t value) { return 0x00 | (value & 0x3); }
+
+/** Data command: write, auto-increment address. */
+constexpr uint8_t address_increment = 0x40;
+
+/** Data command: write, fixed address. */
+constexpr uint8_t address_fixed = 0x44;
+
+/** Data command: read key scan data. */
+constexpr uint8_t read_key = 0x42;
+
+/** Address setting command: 0b1100AAAA. */
+constexpr uint8_t address(uint8_t value) { return 0xC0 | (value & 0xF); }
+
+/** Display control command: 0b1000DPPP. */
+constexpr uint8_t display_control(bool on, uint8_t pulse)
+{
+    return 0x80 | (on ? 0x08 : 0x00) | (pulse & 0x7);
+}
+
+} // namespace command
+
+/** Chip traits for the TM1668 (7 × 10 grid, 10 × 2 keys, four modes). */
+struct TM1668 {
+    static constexpr std::size_t display_size = TM1668_DISPLAY_SIZE;
+    static constexpr std::size_t key_size = TM1668_KEY_SIZE;
+    static constexpr bool has_set_mode = true;
+};
+
+/** Chip traits for the TM1638 (8 × 10 grid, 3 × 8 keys, fixed mode). */
+struct TM1638 {
+    static constexpr std::size_t display_size = TM1638_DISPLAY_SIZE;
+    static constexpr std::size_t key_size = TM1638_KEY_SIZE;
+    static constexpr bool has_set_mode = false;
+};
+
+/** Display mode (TM1668 only), see TM1668_MODE_*. */
+enum class Mode : uint8_t {
+    Grid4x13 = TM1668_MODE_4x13,
+    Grid5x12 = TM1668_MODE_5x12,
+    Grid6x11 = TM1668_MODE_6x11,
+    Grid7x10 = TM1668_MODE_7x10,
+};
+
+/** Pulse width (brightness), see TM1668_PULSE_WIDTH_*. */
+enum class Pulse : uint8_t {
+    Width1 = TM1668_PULSE_WIDTH_1,
+    Width2 = TM1668_PULSE_WIDTH_2,
+    Width4 = TM1668_PULSE_WIDTH_4,
+    Width10 = TM1668_PULSE_WIDTH_10,
+    Width11 = TM1668_PULSE_WIDTH_11,
+    Width12 = TM1668_PULSE_WIDTH_12,
+    Width13 = TM1668_PULSE_WIDTH_13,
+    Width14 = TM1668_PULSE_WIDTH_14,
+};
+
+namespace detail {
+/** Not constexpr: calling it in a constant expression fails to compile. */
+inline void invalid_board_map() {}
+} // namespace detail
+
+/**
+ * @brief Compile a board map into lookup tables, see tm1668_remap_build().
+ *
+ * Meant for constant initialization, so that the tables live in flash and
+ * a line number out of range or used twice is a compile error:
+ *
+ * @code{.cpp}
+ * static constexpr tm1668_remap_t rev_b = tm1668::make_remap({
+ *     {1, 0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+ *     {7, 6, 5, 4, 3, 2, 1, 0},
+ * });
+ * dev.set_remap(rev_b);
+ * @endcode
+ */
+constexpr tm1668_remap_t make_remap(const tm1668_board_map_t &board)
+{
+    bool seg_used[TM1668_REMAP_SEGS] = {};
+    for (uint8_t line : board.seg) {
+        if (seg_used[line]) {
+            detail::invalid_board_map();
+        }
+        seg_used[line] = true;
+    }
+    bool grid_used[TM1668_REMAP_GRIDS] = {};
+    for (uint8_t line : board.grid) {
+        if (grid_used[line]) {
+            detail::invalid_board_map();
+        }
+        grid_used[line] = true;
+    }
+
+    tm1668_remap_t remap{};
+    for (int v = 1; v < 256; v++) {
+        int b = 0;
+        while (!((v >> b) & 1)) {
+            b++;
+        }
+        remap.lo[v] = remap.lo[v & (v - 1)] | (1U << board.seg[b]);
+        remap.hi[v] = remap.hi[v & (v - 1)] | (1U << board.seg[b + 8]);
+    }
+    for (int g = 0; g < TM1668_REMAP_GRIDS; g++) {
+        remap.grid[g] = board.grid[g];
+    }
+    return remap;
+}
+
+#ifdef CONFIG_TM1668_WITH_BUS
+/**
+ * @brief RAII owner of a shared bus.
+ *
+ * The bus is deleted when the object goes out of scope. Devices added to
+ * it must be destroyed first.
+ */
+class Bus {
+  public:
+    explicit Bus(const tm1668_bus_config_t &config)
+    {
+        err_ = tm1668_new_bus(&config, &handle_);
+        if (err_ != ESP_OK) {
+            handle_ = nullptr;
+        }
+    }
+
+    ~Bus()
+    {
+        if (handle_) {
+            tm1668_del_bus(handle_);
+        }
+    }
+
+    Bus(const Bus &) = delete;
+    Bus &operator=(const Bus &) = delete;
+
+    Bus(Bus &&other) noexcept : handle_(other.handle_), err_(other.err_)
+    {
+        other.handle_ = nullptr;
+    }
+
+    Bus &operator=(Bus &&other) noexcept
+    {
+        if (this != &other) {
+            if (handle_) {
+                tm1668_del_bus(handle_);
+            }
+            handle_ = other.handle_;
+            err_ = other.err_;
+            other.handle_ = nullptr;
+        }
+        return *this;
+    }
+
+    /** true if the bus was created successfully. */
+    explicit operator bool() const { return handle_ != nullptr; }
+
+    /** Error returned by tm1668_new_bus(). */
+    esp_err_t error() const { return err_; }
+
+    /** Underlying C handle. */
+    tm1668_bus_handle_t handle() const { return handle_; }
+
+    /** See tm1668_bus_tick(). */
+    esp_err_t tick() { return tm1668_bus_tick(handle_); }
+
+  private:
+    tm1668_bus_handle_t handle_ = nullptr;
+    esp_err_t err_ = ESP_OK;
+};
+#endif // CONFIG_TM1668_WITH_BUS
+
+/**
+ * @brief RAII owner of one TM1668-family device.
+ *
+ * @tparam Chip Chip traits (TM1668 or TM1638).
+ */
+template <typename Chip> class Device {
+  public:
+    /** One full display frame. */
+    using Frame = std::array<uint8_t, Chip::display_size>;
+
+    /** One full key scan. */
+    using Keys = std::array<uint8_t, Chip::key_size>;
+
+#ifdef CONFIG_TM1668_WITH_BUS
+    /** Add a device to an existing bus. */
+    Device(Bus &bus, const tm1668_device_config_t &config) : owns_bus_(false)
+    {
+        err_ = tm1668_bus_add_device(bus.handle(), &config, &handle_);
+        if (err_ != ESP_OK) {
+            handle_ = nullptr;
+        }
+    }
+#endif // CONFIG_TM1668_WITH_BUS
+
+    /** Create a standalone device. */
+    explicit Device(const tm1668_config_t &config) : owns_bus_(true)
+    {
+        err_ = tm1668_new_device(&config, &handle_);
+        if (err_ != ESP_OK) {
+            handle_ = nullptr;
+        }
+    }
+
+    ~Device() { release(); }
+
+    Device(const Device &) = delete;
+    Device &operator=(const Device &) = delete;
+
+    Device(Device &&other) noexcept
+        : handle_(other.handle_), err_(other.err_), owns_bus_(other.owns_bus_)
+    {
+        other.handle_ = nullptr;
+    }
+
+    Device &operator=(Device &&other) noexcept
+    {
+        if (this != &other) {
+            release();
+            handle_ = other.handle_;
+            err_ = other.err_;
+            owns_bus_ = other.owns_bus_;
+            other.handle_ = nullptr;
+        }
+        return *this;
+    }
+
+    /** true if the device was created successfully. */
+    explicit operator bool() const { return handle_ != nullptr; }
+
+    /** Error returned by device creation. */
+    esp_err_t error() const { return err_; }
+
+    /** Underlying C handle. */
+    tm1668_dev_handle_t handle() const { return handle_; }
+
+    /** See tm1668_reset(). */
+    void reset() { tm1668_command_unchecked(handle_, command::address_increment); }
+
+    /** Write a full frame starting at address 0 (auto-increment). */
+    void write(const Frame &frame)
+    {
+        tm1668_display_auto_unchecked(handle_, 0, frame.data(), frame.size());
+    }
+
+    /** Write `N` bytes starting at `Address` (auto-increment). */
+    template <uint8_t Address, std::size_t N>
+    void write(const std::array<uint8_t, N> &data)
+    {
+        static_assert(Address + N <= Chip::display_size,
+                      "display write out of range");
+        tm1668_display_auto_unchecked(handle_, Address, data.data(), N);
+    }
+
+    /** Write one byte at `Address` (fixed address). */
+    template <uint8_t Address> void write_fixed(uint8_t data)
+    {
+        static_assert(Address < Chip::display_size, "display address out of range");
+        tm1668_display_fixed_unchecked(handle_, Address, data);
+    }
+
+    /** Write one byte at a runtime address (checked). */
+    esp_err_t write_fixed(uint8_t address, uint8_t data)
+    {
+        if (address >= Chip::display_size) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        tm1668_display_fixed_unchecked(handle_, address, data);
+        return ESP_OK;
+    }
+
+    /** Stage a full frame without sending it, see tm1668_display_buffer(). */
+    esp_err_t stage(const Frame &frame)
+    {
+        return tm1668_display_buffer(handle_, 0, frame.data(), frame.size());
+    }
+
+    /** Stage one segment, see tm1668_set_segment(). */
+    template <uint8_t Grid, uint8_t Seg> esp_err_t set_segment(bool on)
+    {
+        static_assert(Grid * 2 + Seg / 8 < Chip::display_size,
+                      "segment out of range");
+        return tm1668_set_segment(handle_, Grid, Seg, on);
+    }
+
+    /** Attach a board wiring remap, see tm1668_set_remap(). */
+    esp_err_t set_remap(const tm1668_remap_t &remap)
+    {
+        return tm1668_set_remap(handle_, &remap);
+    }
+
+    /** Bind keys to LEDs, see tm1668_set_reflex(). */
+    template <std::size_t N>
+    esp_err_t set_reflex(const tm1668_reflex_t (&table)[N])
+    {
+        static_assert(N <= TM1668_REFLEX_MAX, "too many reflex bindings");
+        return tm1668_set_reflex(handle_, table, N);
+    }
+
+    /** See tm1668_flush(). */
+    esp_err_t flush() { return tm1668_flush(handle_); }
+
+    /** See tm1668_flush_budget(). */
+    esp_err_t flush_budget(uint32_t budget_us, uint16_t *pending = nullptr)
+    {
+        return tm1668_flush_budget(handle_, budget_us, pending);
+    }
+
+    /** See tm1668_estimate_cost(). */
+    esp_err_t estimate_cost(tm1668_cost_op_t op, uint8_t address, size_t size,
+                            tm1668_cost_t &cost) const
+    {
+        return tm1668_estimate_cost(handle_, op, address, size, &cost);
+    }
+
+    /** Read the key scan data. */
+    Keys read_key()
+    {
+        Keys keys;
+        tm1668_read_key_unchecked(handle_, keys.data(), keys.size());
+        return keys;
+    }
+
+    /** Last key scan data, see tm1668_get_key(). */
+    Keys keys() const
+    {
+        Keys keys{};
+        tm1668_get_key(handle_, keys.data(), keys.size());
+        return keys;
+    }
+
+    /** Debounced key state, see tm1668_get_keys(). */
+    Keys debounced_keys() const
+    {
+        Keys keys{};
+        tm1668_get_keys(handle_, keys.data(), nullptr, nullptr, keys.size());
+        return keys;
+    }
+
+    /** Keys pressed since the last call, see tm1668_get_keys(). */
+    Keys pressed_keys()
+    {
+        Keys keys{};
+        tm1668_get_keys(handle_, nullptr, keys.data(), nullptr, keys.size());
+        return keys;
+    }
+
+    /** Set the display mode (TM1668 only). */
+    void set_mode(Mode mode)
+    {
+        static_assert(Chip::has_set_mode,
+                      "this chip has a fixed display mode");
+        tm1668_command_unchecked(handle_,
+                                 command::mode(static_cast<uint8_t>(mode)));
+    }
+
+    /** Set the display brightness, see tm1668_set_pulse(). */
+    esp_err_t set_pulse(Pulse pulse)
+    {
+        return tm1668_set_pulse(handle_, static_cast<uint8_t>(pulse));
+    }
+
+    /** Turn the display on or off; brightness is preserved. */
+    esp_err_t display(bool on) { return tm1668_display(handle_, on); }
+
+  private:
+    void release()
+    {
+        if (!handle_) {
+            return;
+        }
+#ifdef CONFIG_TM1668_WITH_BUS
+        if (!owns_bus_) {
+            tm1668_bus_rm_device(handle_);
+            handle_ = nullptr;
+            return;
+        }
+#endif // CONFIG_TM1668_WITH_BUS
+        tm1668_del_device(handle_);
+        handle_ = nullptr;
+    }
+
+    tm1668_dev_handle_t handle_ = nullptr;
+    esp_err_t err_ = ESP_OK;
+    bool owns_bus_;
+};
+
+} // namespace tm1668
@@ -0,0 +1,132 @@
+/**
+ * @file tm1668_anim.h
+ * @brief Timer-driven playback of display animations stored in flash.
+ *
+ * An animation is a packed block of frames, each `frame_size` display bytes
+ * starting at `address`, plus an optional table of per-frame durations. The
+ * player reads the frames in place — from `const` data in flash or from a
+ * memory-mapped data partition — and stages each one into the device's
+ * display shadow (see tm1668_display_buffer()). Only the bytes that differ
+ * from the previous frame are marked dirty, so each step sends just the
+ * span that actually changed, and nothing is copied to a RAM frame buffer.
+ *
+ * Frames are advanced from an esp_timer callback. By default the player
+ * also flushes each frame; with `flags.stage_only` set it only stages, and
+ * the frames go out with the next tm1668_flush() or tm1668_bus_tick().
+ *
+ * @code{.c}
+ * static const uint8_t spinner[][4] = {{0x01}, {0x02}, {0x04}, {0x08}};
+ * static const tm1668_anim_t anim = {
+ *     .data = &spinner[0][0],
+ *     .frame_count = 4,
+ *     .frame_size = 4,
+ *     .frame_ms = 80,
+ * };
+ * tm1668_anim_player_handle_t player;
+ * const tm1668_anim_player_config_t config = {.device = handle};
+ * ESP_ERROR_CHECK(tm1668_new_anim_player(&config, &player));
+ * ESP_ERROR_CHECK(tm1668_anim_play(player, &anim, true));
+ * @endcode
+ */
+
+#pragma once
+
+#include "tm1668.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Animation description.
+ *
+ * Neither the description nor the data it points to is copied; both must
+ * stay valid while the animation plays.
+ */
+typedef struct {
+    const uint8_t *data; /**< frame_count × frame_size packed frame bytes */
+    const uint16_t *durations_ms; /**< Per-frame durations, or NULL */
+    uint32_t frame_ms;   /**< Duration of every frame if durations_ms is NULL */
+    size_t frame_count;  /**< Number of frames */
+    uint8_t address;     /**< First display address written by each frame */
+    uint8_t frame_size;  /**< Bytes per frame (address + size <= 16) */
+} tm1668_anim_t;
+
+/** Opaque handle for an animation player. */
+typedef struct tm1668_anim_player_t *tm1668_anim_player_handle_t;
+
+/**
+ * @brief Called from the esp_timer task after the last frame of a
+ *        non-looping animation has been shown for its duration.
+ */
+typedef void (*tm1668_anim_done_cb_t)(tm1668_anim_player_handle_t player,
+                                      void *user_ctx);
+
+/**
+ * @brief Animation player configuration.
+ */
+typedef struct {
+    tm1668_dev_handle_t device;   /**< Target device */
+    tm1668_anim_done_cb_t on_done; /**< Optional completion callback */
+    void *user_ctx;               /**< Passed to on_done */
+    struct {
+        uint32_t stage_only : 1; /**< Stage frames but leave flushing to
+                                      tm1668_flush()/tm1668_bus_tick() */
+    } flags;
+} tm1668_anim_player_config_t;
+
+/**
+ * @brief Create an animation player for one device.
+ *
+ * @param[in]  config     Player configuration.
+ * @param[out] ret_handle Pointer to receive the player handle.
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if the configuration is invalid.
+ *  - ESP_ERR_NO_MEM if memory allocation fails.
+ *  - Other error codes from esp_timer_create().
+ */
+esp_err_t tm1668_new_anim_player(const tm1668_anim_player_config_t *config,
+                                 tm1668_anim_player_handle_t *ret_handle);
+
+/**
+ * @brief Stop playback and delete the player.
+ *
+ * The display keeps showing the last frame.
+ *
+ * @param[in] handle Player handle.
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if handle is NULL.
+ *  - Other error codes from esp_timer_delete(); the player is not freed.
+ */
+esp_err_t tm1668_del_anim_player(tm1668_anim_player_handle_t handle);
+
+/**
+ * @brief Start playing an animation from its first frame.
+ *
+ * The first frame is shown before returning. Any animation already playing
+ * on this player is replaced.
+ *
+ * @param[in] handle Player handle.
+ * @param[in] anim   Animation to play.
+ * @param[in] loop   Restart from the first frame after the last one.
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if the animation is invalid.
+ *  - Other error codes from esp_timer_start_once().
+ */
+esp_err_t tm1668_anim_play(tm1668_anim_player_handle_t handle,
+                           const tm1668_anim_t *anim, bool loop);
+
+/**
+ * @brief Stop playback. The display keeps showing the current frame.
+ *
+ * @param[in] handle Player handle.
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t tm1668_anim_stop(tm1668_anim_player_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
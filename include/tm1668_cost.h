@@ -0,0 +1,121 @@
+/**
+ * @file tm1668_cost.h
+ * @brief Transaction cost estimates and time-budgeted display writes.
+ *
+ * tm1668_estimate_cost() predicts what an operation will put on the bus —
+ * STB frames, CLK cycles and microseconds — from the bus timing and the
+ * device's cached state, without sending anything. The estimate includes
+ * the data command a write needs to switch between fixed-address and
+ * auto-increment mode, skips display addresses unused in the current mode,
+ * and for a flush follows the same burst merging as tm1668_flush().
+ *
+ * The budgeted writes send only what fits into a time slot and leave the
+ * rest pending for the next flush or bus tick:
+ *
+ * @code{.c}
+ * // 200 µs slot for display I/O in every control loop period
+ * uint16_t pending;
+ * ESP_ERROR_CHECK(tm1668_display_budget(handle, 0, frame, sizeof(frame),
+ *                                       200, &pending));
+ * ...
+ * // next period: carry on where the last slot ended
+ * ESP_ERROR_CHECK(tm1668_flush_budget(handle, 200, &pending));
+ * @endcode
+ *
+ * Bit-banged time is the configured delays plus
+ * CONFIG_TM1668_COST_CLOCK_NS of GPIO overhead per clock cycle; timer-engine
+ * frames are timed by their alarms alone. Neither accounts for waiting on
+ * the bus lock, for a bulk write stepping aside for urgent transactions, or
+ * for interrupts, so budgets should keep some margin.
+ */
+
+#pragma once
+
+#include "tm1668.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Operations that tm1668_estimate_cost() can estimate.
+ */
+typedef enum {
+    TM1668_COST_DISPLAY_AUTO,  /**< tm1668_display_auto(address, size) */
+    TM1668_COST_DISPLAY_FIXED, /**< tm1668_display_fixed(address) */
+    TM1668_COST_FLUSH,         /**< tm1668_flush() of what is pending now */
+    TM1668_COST_READ_KEY,      /**< tm1668_read_key(size), without reflexes */
+    TM1668_COST_COMMAND,       /**< One command, e.g. tm1668_set_pulse() */
+} tm1668_cost_op_t;
+
+/**
+ * @brief Estimated bus cost of an operation.
+ */
+typedef struct {
+    uint32_t frames; /**< STB frames, including mode-switch commands */
+    uint32_t clocks; /**< CLK cycles */
+    uint32_t us;     /**< Estimated duration in microseconds */
+} tm1668_cost_t;
+
+/**
+ * @brief Estimate the bus cost of an operation on a device.
+ *
+ * The estimate holds for the device state at the time of the call; other
+ * tasks staging bytes or sending commands in between change it.
+ *
+ * @param[in]  handle   Device handle.
+ * @param[in]  op       Operation.
+ * @param[in]  address  Display address (display operations only).
+ * @param[in]  size     Bytes to write or read (DISPLAY_AUTO, READ_KEY).
+ * @param[out] ret_cost Receives the estimate.
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if an argument is invalid.
+ */
+esp_err_t tm1668_estimate_cost(tm1668_dev_handle_t handle, tm1668_cost_op_t op,
+                               uint8_t address, size_t size,
+                               tm1668_cost_t *ret_cost);
+
+/**
+ * @brief Send the pending display data that fits into a time budget.
+ *
+ * Like tm1668_flush(), but bursts are sent in address order only while
+ * their estimated time fits into the budget; a burst that does not fit is
+ * cut at the last byte that does, and everything after it stays pending.
+ * A pending resync (see tm1668_request_resync()) is sent whole or not at
+ * all; while it is deferred, every address is reported pending.
+ *
+ * @param[in]  handle      Device handle.
+ * @param[in]  budget_us   Time budget in microseconds.
+ * @param[out] ret_pending Receives the addresses still pending (may be
+ *                         NULL); 0 once everything is sent.
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t tm1668_flush_budget(tm1668_dev_handle_t handle, uint32_t budget_us,
+                              uint16_t *ret_pending);
+
+/**
+ * @brief Write display data within a time budget.
+ *
+ * Stores the bytes in the shadow like tm1668_display_auto() and sends as
+ * many of them as fit into the budget, see tm1668_flush_budget(); the rest
+ * stay pending. Other pending bytes of the device are left for the next
+ * flush.
+ *
+ * @param[in]  handle      Device handle.
+ * @param[in]  address     Starting display register address (0–15).
+ * @param[in]  data        Bytes to write.
+ * @param[in]  size        Number of bytes (address + size must not exceed
+ *                         16).
+ * @param[in]  budget_us   Time budget in microseconds.
+ * @param[out] ret_pending Receives the addresses of this write still
+ *                         pending (may be NULL).
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t tm1668_display_budget(tm1668_dev_handle_t handle, uint8_t address,
+                                const uint8_t *data, size_t size,
+                                uint32_t budget_us, uint16_t *ret_pending);
+
+#ifdef __cplusplus
+}
+#endif
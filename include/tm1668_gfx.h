@@ -0,0 +1,196 @@
+/**
+ * @file tm1668_gfx.h
+ * @brief Monochrome bitmap graphics for LED matrices.
+ *
+ * A tm1668_gfx_t is a bitmap of up to 16 × 16 pixels held as one 16-bit
+ * word per row, so drawing works on whole rows with shifts and masks rather
+ * than on display bytes. tm1668_gfx_stage() converts the bitmap into
+ * display RAM layout in one pass and stages it; tm1668_flush() or
+ * tm1668_bus_tick() sends it.
+ *
+ * The layout names how the matrix is wired:
+ *
+ *  - TM1668_GFX_GRID_ROWS: GRIDn drives pixel row n, SEGm column m − 1 —
+ *    a TM1668 in TM1668_MODE_7x10 is a 10 × 7 bitmap, a TM1638 10 × 8.
+ *  - TM1668_GFX_GRID_COLUMNS: GRIDn drives pixel column n, SEGm row m − 1 —
+ *    e.g. an 8 × 8 module on a TM1638. Rows are transposed 8 × 8 bits at a
+ *    time into grid bytes.
+ *
+ * Segment bits outside the bitmap keep their contents, so LEDs on other
+ * segments of the same grids (SEG9/SEG10 of a TM1638 module) can still be
+ * staged separately. Drawing outside the bitmap is clipped.
+ *
+ * @code{.c}
+ * // TM1668 in 7×10 mode: 10 columns, 7 rows
+ * tm1668_gfx_t gfx;
+ * ESP_ERROR_CHECK(tm1668_gfx_init(&gfx, TM1668_GFX_GRID_ROWS, 7, 10));
+ * tm1668_gfx_line(&gfx, 0, 0, 9, 6, true);
+ * tm1668_gfx_sprite(&gfx, &ball, x, 2);
+ * ESP_ERROR_CHECK(tm1668_gfx_stage(handle, &gfx));
+ * ESP_ERROR_CHECK(tm1668_flush(handle));
+ * @endcode
+ */
+
+#pragma once
+
+#include "tm1668.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Largest bitmap width and height. */
+#define TM1668_GFX_MAX 16
+
+/**
+ * @brief How grids and segments map onto the bitmap.
+ */
+typedef enum {
+    TM1668_GFX_GRID_ROWS,    /**< GRIDn is row n − 1, SEGm column m − 1 */
+    TM1668_GFX_GRID_COLUMNS, /**< GRIDn is column n − 1, SEGm row m − 1 */
+} tm1668_gfx_layout_t;
+
+/**
+ * @brief Raster operations of tm1668_gfx_blit().
+ */
+typedef enum {
+    TM1668_GFX_COPY,  /**< Replace the rectangle with the source */
+    TM1668_GFX_OR,    /**< Light the source's set pixels */
+    TM1668_GFX_CLEAR, /**< Clear the source's set pixels */
+    TM1668_GFX_XOR,   /**< Invert the source's set pixels */
+} tm1668_gfx_op_t;
+
+/**
+ * @brief Bitmap; bit x of rows[y] is pixel (x, y), origin top left.
+ */
+typedef struct {
+    tm1668_gfx_layout_t layout; /**< Wiring of the matrix */
+    uint8_t grids;              /**< Grids used (1–8) */
+    uint8_t segments;           /**< Segments used, from SEG1 (1–16) */
+    uint8_t width;              /**< Pixels per row */
+    uint8_t height;             /**< Rows */
+    uint16_t rows[TM1668_GFX_MAX]; /**< Pixel rows */
+} tm1668_gfx_t;
+
+/**
+ * @brief Sprite: a small bitmap drawn through a transparency mask.
+ */
+typedef struct {
+    uint8_t width;         /**< Pixels per row (1–16) */
+    uint8_t height;        /**< Rows (1–16) */
+    const uint16_t *rows;  /**< Pixel rows, bit x = pixel x */
+    const uint16_t *mask;  /**< Opaque pixels per row, or NULL to draw only
+                                the set pixels */
+} tm1668_sprite_t;
+
+/**
+ * @brief Initialize an empty bitmap for a matrix.
+ *
+ * @param[out] gfx      Bitmap.
+ * @param[in]  layout   Wiring of the matrix.
+ * @param[in]  grids    Number of grids wired to the matrix, from GRID1.
+ * @param[in]  segments Number of segments wired to the matrix, from SEG1.
+ *                      On a TM1668 SEG11 does not exist; in the 6×11 to
+ *                      4×13 modes its bit is an unlit column (row).
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if an argument is invalid.
+ */
+esp_err_t tm1668_gfx_init(tm1668_gfx_t *gfx, tm1668_gfx_layout_t layout,
+                          uint8_t grids, uint8_t segments);
+
+/**
+ * @brief Clear every pixel.
+ *
+ * @param[in,out] gfx Bitmap.
+ */
+void tm1668_gfx_clear(tm1668_gfx_t *gfx);
+
+/**
+ * @brief Set or clear one pixel.
+ *
+ * @param[in,out] gfx Bitmap.
+ * @param[in]     x   Column.
+ * @param[in]     y   Row.
+ * @param[in]     on  Light (true) or clear (false) the pixel.
+ */
+void tm1668_gfx_pixel(tm1668_gfx_t *gfx, int x, int y, bool on);
+
+/**
+ * @brief Read one pixel; false outside the bitmap.
+ *
+ * @param[in] gfx Bitmap.
+ * @param[in] x   Column.
+ * @param[in] y   Row.
+ * @return true if the pixel is lit.
+ */
+bool tm1668_gfx_get_pixel(const tm1668_gfx_t *gfx, int x, int y);
+
+/**
+ * @brief Draw a line, both end points included.
+ *
+ * Each row's part of the line is set with one mask.
+ *
+ * @param[in,out] gfx Bitmap.
+ * @param[in]     x0  Start column.
+ * @param[in]     y0  Start row.
+ * @param[in]     x1  End column.
+ * @param[in]     y1  End row.
+ * @param[in]     on  Light (true) or clear (false) the pixels.
+ */
+void tm1668_gfx_line(tm1668_gfx_t *gfx, int x0, int y0, int x1, int y1,
+                     bool on);
+
+/**
+ * @brief Combine a rectangle of source rows into the bitmap.
+ *
+ * @param[in,out] gfx    Bitmap.
+ * @param[in]     x      Column of the source's left edge.
+ * @param[in]     y      Row of the source's top edge.
+ * @param[in]     src    Source rows, bit x = pixel x.
+ * @param[in]     width  Source width (1–16).
+ * @param[in]     height Number of source rows.
+ * @param[in]     op     Raster operation.
+ */
+void tm1668_gfx_blit(tm1668_gfx_t *gfx, int x, int y, const uint16_t *src,
+                     uint8_t width, uint8_t height, tm1668_gfx_op_t op);
+
+/**
+ * @brief Draw a sprite: opaque pixels replace the bitmap, the others leave
+ *        it unchanged.
+ *
+ * @param[in,out] gfx    Bitmap.
+ * @param[in]     sprite Sprite.
+ * @param[in]     x      Column of the sprite's left edge.
+ * @param[in]     y      Row of the sprite's top edge.
+ */
+void tm1668_gfx_sprite(tm1668_gfx_t *gfx, const tm1668_sprite_t *sprite,
+                       int x, int y);
+
+/**
+ * @brief Convert the bitmap into display RAM layout.
+ *
+ * Writes two bytes per grid (2 × grids bytes from address 0) with the
+ * bitmap's segment bits set from the pixels and all other bits 0.
+ *
+ * @param[in]  gfx Bitmap.
+ * @param[out] out Display bytes, at least 2 × grids.
+ */
+void tm1668_gfx_render(const tm1668_gfx_t *gfx, uint8_t *out);
+
+/**
+ * @brief Stage the bitmap into a device's display shadow.
+ *
+ * Only the bitmap's segment bits are replaced, and only bytes that change
+ * are marked pending, as with tm1668_display_buffer().
+ *
+ * @param[in] handle Device handle.
+ * @param[in] gfx    Bitmap.
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t tm1668_gfx_stage(tm1668_dev_handle_t handle,
+                           const tm1668_gfx_t *gfx);
+
+#ifdef __cplusplus
+}
+#endif
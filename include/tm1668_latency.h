@@ -0,0 +1,94 @@
+/**
+ * @file tm1668_latency.h
+ * @brief Key-to-display latency tracer (CONFIG_TM1668_LATENCY).
+ *
+ * When a key scan (tm1668_read_key(), tm1668_bus_tick() or a multi-bus
+ * key read) samples key data that differs from the previous scan, the
+ * sample time is recorded on the device. The application calls
+ * tm1668_latency_tag() when it produces the visual response to that key;
+ * the first display write to the device that then reaches the bus (direct,
+ * flushed or from a bus tick) closes the measurement. The latency — from
+ * sampling to the end of that write — is added to the device's statistics.
+ *
+ * Only the first key change before a response is timed; further changes
+ * until the tagged write are part of the same interaction.
+ *
+ * @code{.c}
+ * tm1668_read_key(handle, keys, sizeof(keys));
+ * if (keys_changed(keys)) {
+ *     tm1668_latency_tag(handle);
+ *     tm1668_display_buffer(handle, 0, feedback, sizeof(feedback));
+ * }
+ * ...
+ * tm1668_latency_stats_t stats;
+ * tm1668_latency_get(handle, &stats);
+ * uint32_t p99 = tm1668_latency_percentile(&stats, 99);
+ * @endcode
+ *
+ * Without CONFIG_TM1668_LATENCY the functions return ESP_ERR_NOT_SUPPORTED.
+ */
+
+#pragma once
+
+#include "tm1668.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of histogram buckets; bucket i counts latencies in
+ *  [2^i, 2^(i+1)) µs, the last one everything above. */
+#define TM1668_LATENCY_BUCKETS 20
+
+/**
+ * @brief Latency statistics of one device.
+ */
+typedef struct {
+    uint32_t count;    /**< Number of measured interactions */
+    uint32_t min_us;   /**< Shortest latency */
+    uint32_t max_us;   /**< Longest latency */
+    uint64_t total_us; /**< Sum of all latencies (mean = total_us / count) */
+    uint32_t hist[TM1668_LATENCY_BUCKETS]; /**< Log2 histogram */
+} tm1668_latency_stats_t;
+
+/**
+ * @brief Mark the next display write to the device as the response to the
+ *        pending key change.
+ *
+ * @param[in] handle Device handle.
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, or ESP_ERR_NOT_SUPPORTED.
+ */
+esp_err_t tm1668_latency_tag(tm1668_dev_handle_t handle);
+
+/**
+ * @brief Copy the latency statistics of a device.
+ *
+ * @param[in]  handle    Device handle.
+ * @param[out] ret_stats Receives the statistics.
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, or ESP_ERR_NOT_SUPPORTED.
+ */
+esp_err_t tm1668_latency_get(tm1668_dev_handle_t handle,
+                             tm1668_latency_stats_t *ret_stats);
+
+/**
+ * @brief Clear the latency statistics and any pending measurement.
+ *
+ * @param[in] handle Device handle.
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, or ESP_ERR_NOT_SUPPORTED.
+ */
+esp_err_t tm1668_latency_reset(tm1668_dev_handle_t handle);
+
+/**
+ * @brief Upper bound of a latency percentile, from the histogram.
+ *
+ * @param[in] stats   Statistics from tm1668_latency_get().
+ * @param[in] percent Percentile (1–100).
+ * @return Upper edge in µs of the bucket holding the percentile (capped at
+ *         max_us), or 0 if nothing was measured.
+ */
+uint32_t tm1668_latency_percentile(const tm1668_latency_stats_t *stats,
+                                   uint8_t percent);
+
+#ifdef __cplusplus
+}
+#endif
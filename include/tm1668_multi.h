@@ -0,0 +1,122 @@
+/**
+ * @file tm1668_multi.h
+ * @brief Bit-sliced parallel transmit across several independent buses.
+ *
+ * A multi-bus group drives up to TM1668_MULTI_MAX_DEVICES devices, each on
+ * its own DIO line, at the same time. Every bit period is clocked with
+ * set/clear writes to the GPIO output register that move the same bit
+ * position of every device's byte stream at once, so refreshing N buses
+ * takes about as long as refreshing one.
+ *
+ * Requirements:
+ * - All CLK, DIO and STB pins of the group are in the first GPIO output
+ *   register bank (GPIO0–GPIO31).
+ * - No two devices of the group share a DIO line. CLK and STB lines may be
+ *   shared or separate.
+ *
+ * The framing is the same as for single-device writes: STB low → address
+ * command → data bytes → STB high, with the auto-increment data command
+ * sent first when any device of the group is in fixed-address mode. Like a
+ * single-device flush, a group write is a bulk transfer: when a key scan,
+ * command or short write is queued, the burst ends at the current byte and
+ * resumes with a new address command once the urgent transaction is done.
+ *
+ * Group transfers are bit-banged at the slowest timing of the group. They
+ * wait for any timer-engine frame in progress (see
+ * CONFIG_TM1668_TIMER_ENGINE) and keep the engine until they are done, so
+ * slow buses never see two transfers interleaved.
+ *
+ * Key scans work the same way: tm1668_multi_read_key() samples the GPIO
+ * input register once per clock and demultiplexes the DIO bits into one
+ * buffer per device. This suits boards where several chips share CLK and
+ * STB but each has its own DIO: create one bus per DIO line with the same
+ * CLK pin, add one device with the same STB pin to each, and group them.
+ */
+
+#pragma once
+
+#include "tm1668.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of devices in one multi-bus group. */
+#define TM1668_MULTI_MAX_DEVICES 8
+
+/**
+ * @brief Multi-bus group configuration.
+ */
+typedef struct {
+    const tm1668_dev_handle_t *devices; /**< Devices, one per DIO line */
+    size_t device_num;                  /**< Number of entries in devices */
+} tm1668_multi_config_t;
+
+/** Opaque handle for a multi-bus group. */
+typedef struct tm1668_multi_t *tm1668_multi_handle_t;
+
+/**
+ * @brief Create a multi-bus group.
+ *
+ * The devices must stay valid for the lifetime of the group.
+ *
+ * @param[in]  config     Group configuration.
+ * @param[out] ret_handle Pointer to receive the new group handle.
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if the configuration is invalid, a pin is outside
+ *    GPIO0–GPIO31, or two devices share a DIO line.
+ *  - ESP_ERR_NO_MEM if memory allocation fails.
+ */
+esp_err_t tm1668_new_multi(const tm1668_multi_config_t *config,
+                           tm1668_multi_handle_t *ret_handle);
+
+/**
+ * @brief Delete a multi-bus group. The devices themselves are not touched.
+ *
+ * @param[in] handle Group handle.
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t tm1668_del_multi(tm1668_multi_handle_t handle);
+
+/**
+ * @brief Write display data to every device of the group in parallel.
+ *
+ * Equivalent to calling tm1668_display_auto() on each device with the same
+ * address and size, but all devices are clocked together. Devices with a
+ * board remap (see tm1668_set_remap()) are sent their chip-order bytes;
+ * the burst then widens to every chip address any device needs, and the
+ * other devices get their shadow contents at the extra addresses.
+ *
+ * @param[in] handle  Group handle.
+ * @param[in] address Starting display register address (0–15).
+ * @param[in] data    One pointer per device (in configuration order), each
+ *                    to `size` bytes.
+ * @param[in] size    Number of bytes per device (address + size must not
+ *                    exceed 16).
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t tm1668_multi_display_auto(tm1668_multi_handle_t handle,
+                                    uint8_t address,
+                                    const uint8_t *const data[], size_t size);
+
+/**
+ * @brief Read the key scan data of every device of the group in parallel.
+ *
+ * Equivalent to calling tm1668_read_key() on each device, but with a single
+ * READ_KEY command phase, a single settling delay and one input register
+ * sample per clock for all devices. The per-device key caches (see
+ * tm1668_get_key()) are updated as well.
+ *
+ * @param[in]  handle Group handle.
+ * @param[out] data   One pointer per device (in configuration order), each
+ *                    to a buffer of at least `size` bytes.
+ * @param[in]  size   Number of bytes per device (typically TM1668_KEY_SIZE).
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t tm1668_multi_read_key(tm1668_multi_handle_t handle,
+                                uint8_t *const data[], size_t size);
+
+#ifdef __cplusplus
+}
+#endif
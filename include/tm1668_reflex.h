@@ -0,0 +1,71 @@
+/**
+ * @file tm1668_reflex.h
+ * @brief Key-to-LED reflex bindings executed in the key scan path.
+ *
+ * A binding copies one key bit to one display bit: the LED is lit while the
+ * key reads as pressed. Bindings are evaluated on every key scan of the
+ * device — tm1668_read_key() and tm1668_bus_tick() — right after the key
+ * bytes are read, and the display bytes they changed are sent before the
+ * scan returns (inside the same bus pass for tm1668_bus_tick()). Feedback
+ * therefore lands one write transaction after the scan, without waking an
+ * application task.
+ *
+ * Bindings follow the raw scan, not the debounced state (see
+ * tm1668_get_keys()), and write the display shadow, so staged frames and
+ * tm1668_set_segment() see the LEDs as the bindings left them. Scans of a
+ * multi-bus group (tm1668_multi_read_key()) update the shadow only; the
+ * bytes go out with the next flush.
+ *
+ * @code{.c}
+ * // TM1638 module: S1–S8 light LED1–LED8 (bit 0 of the odd addresses)
+ * static const tm1668_reflex_t leds[] = {
+ *     {.key_byte = 0, .key_bit = 0, .address = 1, .bit = 0},
+ *     {.key_byte = 1, .key_bit = 0, .address = 3, .bit = 0},
+ *     // ...
+ * };
+ * ESP_ERROR_CHECK(tm1668_set_reflex(handle, leds, 8));
+ * @endcode
+ */
+
+#pragma once
+
+#include "tm1668.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of bindings per device. */
+#define TM1668_REFLEX_MAX 64
+
+/**
+ * @brief One key bit bound to one display bit.
+ */
+typedef struct {
+    uint8_t key_byte; /**< Key scan byte (0 to TM1668_KEY_SIZE − 1) */
+    uint8_t key_bit;  /**< Bit in that byte (0–7) */
+    uint8_t address;  /**< Display address (0–15) */
+    uint8_t bit;      /**< Bit at that address (0–7) */
+} tm1668_reflex_t;
+
+/**
+ * @brief Set the reflex bindings of a device.
+ *
+ * The table is not copied and must stay valid while bound. Several
+ * bindings may drive the same display byte; a display bit bound twice
+ * follows the later binding.
+ *
+ * @param[in] handle Device handle.
+ * @param[in] table  Bindings, or NULL to remove them.
+ * @param[in] count  Number of bindings (≤ TM1668_REFLEX_MAX).
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if the handle is NULL, count is too large or a
+ *    binding is out of range.
+ */
+esp_err_t tm1668_set_reflex(tm1668_dev_handle_t handle,
+                            const tm1668_reflex_t *table, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
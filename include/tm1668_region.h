@@ -0,0 +1,105 @@
+/**
+ * @file tm1668_region.h
+ * @brief Display regions owned by different tasks, sent by one merged flush.
+ *
+ * A region is a named, contiguous span of a device's display addresses.
+ * Regions of one device never overlap, so each can be given to one task
+ * (a clock, a status line, an alarm indicator) that updates it with
+ * region-relative offsets and never touches, or resends, bytes it does not
+ * own. Region writes only stage: they store into the device shadow under
+ * its short buffer lock and mark the changed bytes dirty, so tasks never
+ * wait for each other's bus transfers.
+ *
+ * One tm1668_flush() or tm1668_bus_tick() then sends the dirty bytes of
+ * all regions together, merged into the fewest auto-increment bursts.
+ *
+ * @code{.c}
+ * // TM1638: digits 1–4 for the clock task, 5–8 for the status task
+ * const tm1668_region_config_t clock_cfg = {
+ *     .name = "clock", .address = 0, .size = 8,
+ * };
+ * tm1668_region_handle_t clock;
+ * ESP_ERROR_CHECK(tm1668_new_region(handle, &clock_cfg, &clock));
+ * // in the clock task
+ * ESP_ERROR_CHECK(tm1668_region_write(clock, 0, digits, sizeof(digits)));
+ * // in the display task
+ * ESP_ERROR_CHECK(tm1668_flush(handle));
+ * @endcode
+ */
+
+#pragma once
+
+#include "tm1668.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Region configuration.
+ */
+typedef struct {
+    const char *name; /**< Name for log messages (kept by reference) */
+    uint8_t address;  /**< First display address of the region */
+    uint8_t size;     /**< Number of addresses (address + size <= 16) */
+} tm1668_region_config_t;
+
+/** Opaque handle for a display region. */
+typedef struct tm1668_region_t *tm1668_region_handle_t;
+
+/**
+ * @brief Create a region on a device.
+ *
+ * Delete all regions of a device before the device itself.
+ *
+ * @param[in]  device     Device handle.
+ * @param[in]  config     Region configuration.
+ * @param[out] ret_region Receives the region handle.
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if an argument is invalid.
+ *  - ESP_ERR_INVALID_STATE if the span overlaps another region.
+ *  - ESP_ERR_NO_MEM if out of memory.
+ */
+esp_err_t tm1668_new_region(tm1668_dev_handle_t device,
+                            const tm1668_region_config_t *config,
+                            tm1668_region_handle_t *ret_region);
+
+/**
+ * @brief Delete a region; its display bytes keep their contents.
+ *
+ * @param[in] region Region handle.
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t tm1668_del_region(tm1668_region_handle_t region);
+
+/**
+ * @brief Stage bytes into a region.
+ *
+ * Like tm1668_display_buffer() with an address relative to the region;
+ * only the bytes that change are marked dirty.
+ *
+ * @param[in] region Region handle.
+ * @param[in] offset First byte to write, relative to the region.
+ * @param[in] data   Bytes to write.
+ * @param[in] size   Number of bytes (offset + size <= region size).
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if an argument is invalid or the bytes do not
+ *    fit in the region.
+ */
+esp_err_t tm1668_region_write(tm1668_region_handle_t region, uint8_t offset,
+                              const uint8_t *data, size_t size);
+
+/**
+ * @brief Stage the same byte into the whole region, e.g. 0 to clear it.
+ *
+ * @param[in] region Region handle.
+ * @param[in] value  Byte to write.
+ * @return ESP_OK on success, or ESP_ERR_INVALID_ARG.
+ */
+esp_err_t tm1668_region_fill(tm1668_region_handle_t region, uint8_t value);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,125 @@
+/**
+ * @file tm1668_remap.h
+ * @brief Board wiring remap: logical segments and grids to chip lines.
+ *
+ * Applications draw into a logical layout in which GRIDn owns addresses
+ * 2n (segments 0–7) and 2n+1 (segments 8–15), LSB first — the layout of an
+ * unrouted board. A board map tells which chip SEG and GRID line drives each
+ * logical segment and grid; tm1668_remap_build() compiles it once into
+ * byte-indexed lookup tables, and a device with a remap attached runs every
+ * flush through them:
+ *
+ *   physical[grid[g]] = lo[logical byte 2g] | hi[logical byte 2g + 1]
+ *
+ * i.e. two table lookups and an OR per grid instead of a loop over all
+ * sixteen bits. The shadow buffer, tm1668_display_buffer(),
+ * tm1668_set_segment() and the animation player keep working in logical
+ * terms; only the bytes put on the wire change.
+ *
+ * @code{.c}
+ * // Rev B: SEG1/SEG2 swapped, digits wired right to left
+ * static const tm1668_board_map_t rev_b = {
+ *     .seg = {1, 0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+ *     .grid = {7, 6, 5, 4, 3, 2, 1, 0},
+ * };
+ * static tm1668_remap_t remap;
+ * ESP_ERROR_CHECK(tm1668_remap_build(&rev_b, &remap));
+ * ESP_ERROR_CHECK(tm1668_set_remap(handle, &remap));
+ * @endcode
+ *
+ * From C++, tm1668::make_remap() builds the tables at compile time, so
+ * they can live in flash.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "tm1668.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of logical (and chip) segment lines. */
+#define TM1668_REMAP_SEGS 16
+
+/** Number of logical (and chip) grid lines. */
+#define TM1668_REMAP_GRIDS 8
+
+/**
+ * @brief Board description: the chip line that drives each logical line.
+ *
+ * Lines are numbered from 0 (SEG1 = 0, GRID1 = 0). Both arrays must be
+ * permutations: every chip line used exactly once.
+ */
+typedef struct {
+    uint8_t seg[TM1668_REMAP_SEGS];   /**< Chip SEG line of logical segment s */
+    uint8_t grid[TM1668_REMAP_GRIDS]; /**< Chip GRID line of logical grid g */
+} tm1668_board_map_t;
+
+/** Board map of a board wired straight through. */
+#define TM1668_BOARD_MAP_IDENTITY                                              \
+    ((tm1668_board_map_t){                                                     \
+        .seg = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},         \
+        .grid = {0, 1, 2, 3, 4, 5, 6, 7},                                      \
+    })
+
+/**
+ * @brief Compiled board map (1 KiB of tables).
+ *
+ * Must stay valid while attached to a device.
+ */
+typedef struct {
+    uint16_t lo[256]; /**< Chip SEG bits of each logical segment 0–7 byte */
+    uint16_t hi[256]; /**< Chip SEG bits of each logical segment 8–15 byte */
+    uint8_t grid[TM1668_REMAP_GRIDS]; /**< Chip GRID line of each grid */
+} tm1668_remap_t;
+
+/**
+ * @brief Compile a board map into lookup tables.
+ *
+ * @param[in]  board Board description.
+ * @param[out] remap Receives the tables.
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if a pointer is NULL, a line number is out of
+ *    range or a chip line is used twice.
+ */
+esp_err_t tm1668_remap_build(const tm1668_board_map_t *board,
+                             tm1668_remap_t *remap);
+
+/**
+ * @brief Attach a compiled board map to a device.
+ *
+ * Every display address is marked dirty, so the next tm1668_flush() or
+ * tm1668_bus_tick() rewrites the whole display in the new order. With a
+ * remap attached, tm1668_display_auto() and tm1668_display_fixed() update
+ * the shadow and flush it (pending staged bytes go out with them).
+ *
+ * @param[in] handle Device handle.
+ * @param[in] remap  Compiled board map, kept by reference; NULL detaches.
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if the handle is NULL.
+ */
+esp_err_t tm1668_set_remap(tm1668_dev_handle_t handle,
+                           const tm1668_remap_t *remap);
+
+/**
+ * @brief Remap a whole logical frame into chip display RAM order.
+ *
+ * For frames sent without a device shadow, e.g. with
+ * tm1668_multi_display_auto().
+ *
+ * @param[in]  remap    Compiled board map.
+ * @param[in]  logical  Logical frame (16 bytes).
+ * @param[out] physical Receives the chip frame (16 bytes, may not alias
+ *                      logical).
+ */
+void tm1668_remap_frame(const tm1668_remap_t *remap, const uint8_t *logical,
+                        uint8_t *physical);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,101 @@
+/**
+ * @file tm1668_seg7.h
+ * @brief Number formatting straight into 7-segment codes.
+ *
+ * Renders decimal (optionally fixed-point) and hexadecimal numbers into
+ * segment bytes ready for tm1668_display_buffer() / tm1668_display_auto(),
+ * with leading-zero blanking, a minus sign and decimal-point placement.
+ * Decimal digits are produced by a double-dabble (shift-and-add-3) pass on
+ * all BCD digits at once, so no division or modulo by 10 is involved.
+ *
+ * Segment bits follow the usual wiring of SEG1–SEG8 to a–g and dp:
+ *
+ * @verbatim
+ *    a            bit 0 = a, bit 1 = b, ... bit 6 = g, bit 7 = dp
+ *  f   b
+ *    g
+ *  e   c
+ *    d   dp
+ * @endverbatim
+ *
+ * @code{.c}
+ * // "-12.5" right-aligned in 6 digits at every other address (TM1638)
+ * uint8_t buf[TM1638_DISPLAY_SIZE] = {0};
+ * const tm1668_seg7_format_t fmt = {.width = 6, .stride = 2, .point = 1};
+ * tm1668_seg7_dec(&fmt, -125, buf);
+ * tm1668_display_buffer(handle, 0, buf, sizeof(buf));
+ * @endcode
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Segment code of the decimal point. */
+#define TM1668_SEG7_DP 0x80
+
+/** Segment code of a minus sign (segment g). */
+#define TM1668_SEG7_MINUS 0x40
+
+/** Segment code of a blank digit. */
+#define TM1668_SEG7_BLANK 0x00
+
+/** Segment codes of the hexadecimal digits 0–9, A, b, C, d, E, F. */
+extern const uint8_t tm1668_seg7_digits[16];
+
+/**
+ * @brief Output format.
+ */
+typedef struct {
+    uint8_t width;  /**< Number of digit positions (1–16) */
+    uint8_t stride; /**< Bytes from one digit to the next in the output
+                         buffer; 0 or 1 = contiguous, 2 = every other
+                         display address (bytes in between are untouched) */
+    uint8_t point;  /**< Digits after the decimal point (0 = integer) */
+    uint8_t zero_pad : 1; /**< Keep leading zeros instead of blanking them */
+} tm1668_seg7_format_t;
+
+/**
+ * @brief Render a signed decimal or fixed-point number.
+ *
+ * `value` is the number scaled by 10^point, e.g. 1234 with point = 2 shows
+ * "12.34". Digits are right-aligned; leading zeros are blanked down to the
+ * units digit unless `zero_pad` is set. A minus sign is placed left of the
+ * first digit (in the leftmost position with `zero_pad`).
+ *
+ * @param[in]  fmt   Output format.
+ * @param[in]  value Value to render.
+ * @param[out] out   Output buffer of at least (width − 1) × stride + 1 bytes.
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if an argument is invalid.
+ *  - ESP_ERR_INVALID_SIZE if the number does not fit; every digit position
+ *    then shows a minus sign.
+ */
+esp_err_t tm1668_seg7_dec(const tm1668_seg7_format_t *fmt, int32_t value,
+                          uint8_t *out);
+
+/**
+ * @brief Render an unsigned hexadecimal number.
+ *
+ * Same layout rules as tm1668_seg7_dec(), without a sign. `point` places
+ * a decimal point as well, for example to separate fields.
+ *
+ * @param[in]  fmt   Output format.
+ * @param[in]  value Value to render.
+ * @param[out] out   Output buffer of at least (width − 1) × stride + 1 bytes.
+ * @return Same as tm1668_seg7_dec().
+ */
+esp_err_t tm1668_seg7_hex(const tm1668_seg7_format_t *fmt, uint32_t value,
+                          uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
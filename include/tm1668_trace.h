@@ -0,0 +1,82 @@
+/**
+ * @file tm1668_trace.h
+ * @brief Bus transition trace capture (CONFIG_TM1668_TRACE).
+ *
+ * When CONFIG_TM1668_TRACE is enabled, every CLK, DIO and STB level change
+ * made by the driver, and every DIO level it samples, is appended to a RAM
+ * ring buffer together with the CPU cycle count. Repeated writes of the same
+ * level are not recorded, so the buffer holds transitions only.
+ *
+ * The capture can be read back with tm1668_trace_read() or printed with
+ * tm1668_trace_dump(). The printed form is understood by the host tool
+ * `tools/tm1668_trace.py`, which writes a VCD file for GTKWave and a decoded
+ * command log:
+ *
+ * @code{.sh}
+ * idf.py monitor | tee capture.log
+ * python tools/tm1668_trace.py capture.log -o capture.vcd
+ * @endcode
+ *
+ * Without CONFIG_TM1668_TRACE the functions are still declared but
+ * tm1668_trace_read() always returns 0.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Role of a traced pin. */
+typedef enum {
+    TM1668_TRACE_CLK = 0, /**< Serial clock */
+    TM1668_TRACE_DIO = 1, /**< Serial data */
+    TM1668_TRACE_STB = 2, /**< Strobe (chip select) */
+} tm1668_trace_role_t;
+
+/**
+ * @brief One recorded pin transition.
+ */
+typedef struct {
+    uint32_t cycles; /**< CPU cycle count at the transition (wraps) */
+    uint8_t pin;     /**< GPIO number */
+    uint8_t role;    /**< tm1668_trace_role_t */
+    uint8_t level;   /**< New level (0 or 1) */
+    uint8_t reserved;
+} tm1668_trace_event_t;
+
+/**
+ * @brief Read and remove the oldest events from the trace buffer.
+ *
+ * @param[out] events Buffer to receive the events, oldest first.
+ * @param[in]  max    Capacity of events.
+ * @return Number of events copied.
+ */
+size_t tm1668_trace_read(tm1668_trace_event_t *events, size_t max);
+
+/**
+ * @brief Discard every recorded event and the overflow count.
+ */
+void tm1668_trace_clear(void);
+
+/**
+ * @brief Number of events overwritten because the buffer was full since the
+ *        last tm1668_trace_clear().
+ */
+uint32_t tm1668_trace_dropped(void);
+
+/**
+ * @brief Print and remove every recorded event.
+ *
+ * Output is one `TM1668TRACE` line per event on stdout, framed by a header
+ * carrying the CPU frequency and a trailer carrying the overflow count, for
+ * tools/tm1668_trace.py.
+ */
+void tm1668_trace_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
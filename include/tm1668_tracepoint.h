@@ -0,0 +1,70 @@
+/**
+ * @file tm1668_tracepoint.h
+ * @brief Compile-time tracepoint hooks at transaction boundaries.
+ *
+ * The driver calls these macros when it asserts or releases an STB line,
+ * sends a command byte, writes display data and reads key data. They
+ * expand to nothing unless bound, so an unbound build carries no code for
+ * them. To bind them, enable CONFIG_TM1668_TRACEPOINTS and name a header in
+ * CONFIG_TM1668_TRACEPOINT_HEADER that defines any subset of them, e.g. for
+ * a logic analyser:
+ *
+ * @code{.c}
+ * // tm1668_tracepoints.h
+ * #include "hal/gpio_ll.h"
+ * #define TM1668_TP_DISPLAY_BEGIN(stb, address, size)                      \
+ *     gpio_ll_set_level(&GPIO, 4, 1)
+ * #define TM1668_TP_DISPLAY_END(stb) gpio_ll_set_level(&GPIO, 4, 0)
+ * @endcode
+ *
+ * or to SystemView with SEGGER_SYSVIEW_RecordU32() / RecordEndCall(), or
+ * to app_trace. The header must be on the component's include path, e.g.
+ * with idf_build_set_property(COMPILE_OPTIONS "-I<dir>" APPEND) in the
+ * project CMakeLists.txt.
+ *
+ * Hooks on fast buses run with interrupts disabled (inside the bus
+ * spinlock) and STB hooks of slow buses run in the timer engine's
+ * interrupt, so bound hooks must be short, non-blocking and ISR-safe.
+ * `stb` is the STB GPIO number of the device concerned.
+ */
+
+#pragma once
+
+#include "sdkconfig.h"
+
+#ifdef CONFIG_TM1668_TRACEPOINTS
+#include CONFIG_TM1668_TRACEPOINT_HEADER
+#endif
+
+/** STB line `stb` driven to `level` (0 = frame starts, 1 = frame ends). */
+#ifndef TM1668_TP_STB
+#define TM1668_TP_STB(stb, level) ((void)0)
+#endif
+
+/** Command byte `command` about to be sent in a frame of its own. */
+#ifndef TM1668_TP_COMMAND
+#define TM1668_TP_COMMAND(stb, command) ((void)0)
+#endif
+
+/**
+ * Display write frame of up to `size` bytes from `address` starting (a
+ * bulk write cut short for urgent requests resumes in a new frame).
+ */
+#ifndef TM1668_TP_DISPLAY_BEGIN
+#define TM1668_TP_DISPLAY_BEGIN(stb, address, size) ((void)0)
+#endif
+
+/** Display write frame ended. */
+#ifndef TM1668_TP_DISPLAY_END
+#define TM1668_TP_DISPLAY_END(stb) ((void)0)
+#endif
+
+/** Key read frame of `size` bytes starting. */
+#ifndef TM1668_TP_KEY_BEGIN
+#define TM1668_TP_KEY_BEGIN(stb, size) ((void)0)
+#endif
+
+/** Key read frame ended; `data` holds the `size` bytes read. */
+#ifndef TM1668_TP_KEY_END
+#define TM1668_TP_KEY_END(stb, data, size) ((void)0)
+#endif
@@ -0,0 +1,181 @@
+/**
+ * @file tm1668_linux.h
+ * @brief TM1668 / TM1638 protocol on Linux through the GPIO character device.
+ *
+ * Drives the same serial protocol as the ESP-IDF driver from user space with
+ * libgpiod (v2). CLK, DIO and all STB lines are requested as one line
+ * request, so every clock edge — CLK together with the next DIO bit — is a
+ * single multi-line set_values ioctl instead of one write per line.
+ *
+ * Several devices may share CLK and DIO; each has its own STB line and is
+ * addressed by its index in tm1668_linux_config_t::stb_offsets.
+ *
+ * @code{.c}
+ * const unsigned int stb[] = {17};
+ * const tm1668_linux_config_t config = {
+ *     .chip_path = "/dev/gpiochip0",
+ *     .clk_offset = 27,
+ *     .dio_offset = 22,
+ *     .stb_offsets = stb,
+ *     .device_num = 1,
+ *     .timing = TM1668_LINUX_TIMING_DEFAULT,
+ * };
+ * tm1668_linux_handle_t handle;
+ * if (tm1668_linux_open(&config, &handle) == 0) {
+ *     tm1668_linux_display_auto(handle, 0, 0, frame, sizeof(frame));
+ *     tm1668_linux_display(handle, 0, true);
+ *     tm1668_linux_close(handle);
+ * }
+ * @endcode
+ *
+ * All functions return 0 on success or a negative errno value. A handle may
+ * be used from several threads; transactions are serialized internally.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of devices (STB lines) on one handle. */
+#define TM1668_LINUX_MAX_DEVICES 8
+
+/**
+ * @brief Serial timing.
+ *
+ * The delays are added on top of the ioctl round trip, which alone is
+ * typically a few microseconds on an SBC.
+ */
+typedef struct {
+    uint32_t delay_us;          /**< Extra wait per clock half-cycle */
+    uint32_t read_key_delay_us; /**< Settling delay after READ_KEY */
+} tm1668_linux_timing_t;
+
+/** Datasheet minimum timing, matching the ESP-IDF driver defaults. */
+#define TM1668_LINUX_TIMING_DEFAULT                                            \
+    ((tm1668_linux_timing_t){.delay_us = 1, .read_key_delay_us = 2})
+
+/**
+ * @brief Line configuration.
+ */
+typedef struct {
+    const char *chip_path;            /**< GPIO chip, e.g. "/dev/gpiochip0" */
+    const char *consumer;             /**< Consumer label (NULL = "tm1668") */
+    unsigned int clk_offset;          /**< CLK line offset on the chip */
+    unsigned int dio_offset;          /**< DIO line offset (open-drain) */
+    const unsigned int *stb_offsets;  /**< STB line offset of each device */
+    size_t device_num;                /**< Number of entries in stb_offsets */
+    tm1668_linux_timing_t timing;     /**< Serial timing */
+} tm1668_linux_config_t;
+
+/** Handle of an opened set of lines. */
+typedef struct tm1668_linux_t *tm1668_linux_handle_t;
+
+/**
+ * @brief Request the lines and return a handle.
+ *
+ * All lines start high (idle). DIO is requested open-drain with the
+ * pull-up bias enabled, as on the ESP-IDF side.
+ *
+ * @param[in]  config     Line configuration.
+ * @param[out] ret_handle Receives the handle.
+ * @return 0, -EINVAL for a bad configuration, -ENOMEM, or the errno of the
+ *         failed chip open / line request.
+ */
+int tm1668_linux_open(const tm1668_linux_config_t *config,
+                      tm1668_linux_handle_t *ret_handle);
+
+/**
+ * @brief Release the lines and free the handle.
+ *
+ * @param[in] handle Handle from tm1668_linux_open(), or NULL.
+ */
+void tm1668_linux_close(tm1668_linux_handle_t handle);
+
+/**
+ * @brief Reset a device to auto-increment address mode.
+ *
+ * @param[in] handle Handle.
+ * @param[in] dev    Device index.
+ * @return 0, -EINVAL, or the errno of a failed line update.
+ */
+int tm1668_linux_reset(tm1668_linux_handle_t handle, size_t dev);
+
+/**
+ * @brief Set the grid × segment mode (TM1668 only).
+ *
+ * @param[in] handle Handle.
+ * @param[in] dev    Device index.
+ * @param[in] mode   TM1668_MODE_4x13 (0) through TM1668_MODE_7x10 (3).
+ * @return 0, -EINVAL, or the errno of a failed line update.
+ */
+int tm1668_linux_set_mode(tm1668_linux_handle_t handle, size_t dev,
+                          uint8_t mode);
+
+/**
+ * @brief Set the brightness, keeping the on/off state.
+ *
+ * @param[in] handle Handle.
+ * @param[in] dev    Device index.
+ * @param[in] width  TM1668_PULSE_WIDTH_1 (0) through TM1668_PULSE_WIDTH_14 (7).
+ * @return 0, -EINVAL, or the errno of a failed line update.
+ */
+int tm1668_linux_set_pulse(tm1668_linux_handle_t handle, size_t dev,
+                           uint8_t width);
+
+/**
+ * @brief Turn the display on or off, keeping the brightness.
+ *
+ * @param[in] handle Handle.
+ * @param[in] dev    Device index.
+ * @param[in] on     Display on.
+ * @return 0, -EINVAL, or the errno of a failed line update.
+ */
+int tm1668_linux_display(tm1668_linux_handle_t handle, size_t dev, bool on);
+
+/**
+ * @brief Write display bytes in one auto-increment transaction.
+ *
+ * @param[in] handle  Handle.
+ * @param[in] dev     Device index.
+ * @param[in] address Starting display address (0–15).
+ * @param[in] data    Bytes to write.
+ * @param[in] size    Number of bytes (address + size ≤ 16).
+ * @return 0, -EINVAL, or the errno of a failed line update.
+ */
+int tm1668_linux_display_auto(tm1668_linux_handle_t handle, size_t dev,
+                              uint8_t address, const uint8_t *data,
+                              size_t size);
+
+/**
+ * @brief Write one display byte at a fixed address.
+ *
+ * @param[in] handle  Handle.
+ * @param[in] dev     Device index.
+ * @param[in] address Display address (0–15).
+ * @param[in] data    Byte to write.
+ * @return 0, -EINVAL, or the errno of a failed line update.
+ */
+int tm1668_linux_display_fixed(tm1668_linux_handle_t handle, size_t dev,
+                               uint8_t address, uint8_t data);
+
+/**
+ * @brief Read key scan data.
+ *
+ * @param[in]  handle Handle.
+ * @param[in]  dev    Device index.
+ * @param[out] data   Receives the key bytes.
+ * @param[in]  size   Number of bytes (1–5; TM1638 has 4).
+ * @return 0, -EINVAL, or the errno of a failed line access.
+ */
+int tm1668_linux_read_key(tm1668_linux_handle_t handle, size_t dev,
+                          uint8_t *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
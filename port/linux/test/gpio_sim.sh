@@ -0,0 +1,28 @@
+#!/bin/sh
+# Run test_tm1668_linux_gpio_sim on a freshly created gpio-sim chip.
+#
+# Needs root, configfs and the gpio-sim module; exits 77 (skipped) without
+# them. Usage: gpio_sim.sh <test binary>
+set -e
+
+CFG=/sys/kernel/config/gpio-sim/tm1668-test
+
+modprobe gpio-sim 2>/dev/null || true
+if [ "$(id -u)" -ne 0 ] || [ ! -d /sys/kernel/config/gpio-sim ]; then
+    echo "gpio-sim not available, skipping"
+    exit 77
+fi
+
+cleanup() {
+    echo 0 > "$CFG/live" 2>/dev/null || true
+    rmdir "$CFG/bank0" "$CFG" 2>/dev/null || true
+}
+trap cleanup EXIT
+
+mkdir "$CFG" "$CFG/bank0"
+echo 8 > "$CFG/bank0/num_lines"
+echo 1 > "$CFG/live"
+chip=$(cat "$CFG/bank0/chip_name")
+dev=$(cat "$CFG/dev_name")
+
+"$1" "/dev/$chip" "/sys/devices/platform/$dev/$chip"
@@ -0,0 +1,368 @@
+/**
+ * @file gpiod_sim.c
+ * @brief Fake libgpiod v2 driving simulated TM1668 / TM1638 chips.
+ *
+ * The chip model decodes commands from the datasheet encoding directly,
+ * not from src/tm1668_proto.h, so it checks the shared encoding as well
+ * as the backend's framing.
+ */
+
+#include "gpiod.h"
+#include "sim.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Line offsets the fake chip provides. */
+#define LINES 64
+
+/** Most chips on one set of lines. */
+#define CHIPS 8
+
+struct gpiod_chip {
+    int unused;
+};
+
+struct gpiod_line_settings {
+    enum gpiod_line_direction direction;
+    enum gpiod_line_value value;
+    enum gpiod_line_drive drive;
+    enum gpiod_line_bias bias;
+};
+
+struct gpiod_line_config {
+    bool set[LINES];
+    struct gpiod_line_settings settings[LINES];
+};
+
+struct gpiod_request_config {
+    int unused;
+};
+
+struct gpiod_line_request {
+    bool requested[LINES];
+};
+
+/**
+ * @brief Chip with its shift-register state.
+ */
+typedef struct {
+    sim_chip_t state;   /**< State visible to the test */
+    unsigned int stb;   /**< STB line offset */
+    bool selected;      /**< STB is low */
+    bool reading;       /**< Shifting key data out */
+    uint8_t shift;      /**< Byte being received */
+    int bits;           /**< Bits received of shift */
+    size_t out_bit;     /**< Next key bit to shift out */
+    int dio;            /**< Level the chip drives on DIO (1 = released) */
+    uint8_t address;    /**< Display address pointer */
+    sim_frame_t frame;  /**< Frame being received */
+} chip_t;
+
+static struct {
+    int level[LINES];
+    unsigned int clk;
+    unsigned int dio;
+    chip_t chips[CHIPS];
+    size_t chip_num;
+    struct gpiod_line_request request;
+    int errors;
+} sim;
+
+static struct gpiod_chip sim_gpiochip;
+
+void sim_wire(unsigned int clk, unsigned int dio, const unsigned int *stb,
+              size_t num)
+{
+    memset(&sim, 0, sizeof(sim));
+    for (int n = 0; n < LINES; n++) {
+        sim.level[n] = 1;
+    }
+    sim.clk = clk;
+    sim.dio = dio;
+    sim.chip_num = num;
+    for (size_t i = 0; i < num; i++) {
+        sim.chips[i].stb = stb[i];
+        sim.chips[i].dio = 1;
+    }
+}
+
+sim_chip_t *sim_chip(size_t index) { return &sim.chips[index].state; }
+
+void sim_clear_log(void)
+{
+    for (size_t i = 0; i < sim.chip_num; i++) {
+        sim.chips[i].state.frames = 0;
+    }
+}
+
+int sim_errors(void) { return sim.errors; }
+
+/** Execute a byte received by a chip. */
+static void _receive(chip_t *chip, uint8_t byte)
+{
+    sim_frame_t *frame = &chip->frame;
+    if (frame->len < SIM_FRAME_MAX) {
+        frame->bytes[frame->len] = byte;
+    }
+    if (frame->len++) {
+        /* Data bytes only follow an address command. */
+        if ((frame->bytes[0] & 0xC0) != 0xC0) {
+            sim.errors++;
+            return;
+        }
+        chip->state.display[chip->address] = byte;
+        if (!chip->state.address_fixed) {
+            chip->address = (chip->address + 1) & 0xF;
+        }
+        return;
+    }
+    switch (byte & 0xC0) {
+    case 0x00:
+        chip->state.mode = byte & 0x3;
+        break;
+    case 0x40:
+        if (byte & 0x02) {
+            chip->reading = true;
+            chip->out_bit = 0;
+        } else {
+            chip->state.address_fixed = byte & 0x04;
+        }
+        break;
+    case 0x80:
+        chip->state.control = byte;
+        break;
+    default:
+        chip->address = byte & 0xF;
+        break;
+    }
+}
+
+/** Apply new line levels and let the chips react to the edges. */
+static void _update(const int *old)
+{
+    bool clk_rise = !old[sim.clk] && sim.level[sim.clk];
+    bool clk_fall = old[sim.clk] && !sim.level[sim.clk];
+    if (clk_rise && old[sim.dio] != sim.level[sim.dio]) {
+        /* DIO must be stable before CLK rises. */
+        sim.errors++;
+    }
+    for (size_t i = 0; i < sim.chip_num; i++) {
+        chip_t *chip = &sim.chips[i];
+        int stb = sim.level[chip->stb];
+        if (chip->selected && stb) {
+            /* End of frame. */
+            if (chip->bits) {
+                sim.errors++;
+            }
+            if (chip->state.frames < SIM_LOG_MAX) {
+                chip->state.log[chip->state.frames++] = chip->frame;
+            }
+            chip->selected = false;
+            chip->reading = false;
+            chip->dio = 1;
+            continue;
+        }
+        if (!chip->selected && !stb) {
+            chip->selected = true;
+            chip->bits = 0;
+            memset(&chip->frame, 0, sizeof(chip->frame));
+            continue;
+        }
+        if (!chip->selected) {
+            continue;
+        }
+        if (chip->reading) {
+            if (clk_fall) {
+                size_t n = chip->out_bit++;
+                chip->dio = n < 8 * sizeof(chip->state.keys)
+                                ? (chip->state.keys[n / 8] >> (n % 8)) & 1
+                                : 1;
+            }
+            if (!sim.level[sim.dio]) {
+                /* The host must release DIO while the chip drives it. */
+                sim.errors++;
+            }
+        } else if (clk_rise) {
+            chip->shift |= sim.level[sim.dio] << chip->bits;
+            if (++chip->bits == 8) {
+                _receive(chip, chip->shift);
+                chip->shift = 0;
+                chip->bits = 0;
+            }
+        }
+    }
+}
+
+struct gpiod_chip *gpiod_chip_open(const char *path)
+{
+    if (strcmp(path, SIM_CHIP_PATH) != 0) {
+        errno = ENOENT;
+        return NULL;
+    }
+    return &sim_gpiochip;
+}
+
+void gpiod_chip_close(struct gpiod_chip *chip) { (void)chip; }
+
+struct gpiod_line_request *
+gpiod_chip_request_lines(struct gpiod_chip *chip,
+                         struct gpiod_request_config *req_cfg,
+                         struct gpiod_line_config *line_cfg)
+{
+    (void)chip;
+    (void)req_cfg;
+    memset(&sim.request, 0, sizeof(sim.request));
+    for (unsigned int n = 0; n < LINES; n++) {
+        if (!line_cfg->set[n]) {
+            continue;
+        }
+        const struct gpiod_line_settings *s = &line_cfg->settings[n];
+        bool dio = n == sim.dio;
+        if (s->direction != GPIOD_LINE_DIRECTION_OUTPUT ||
+            s->value != GPIOD_LINE_VALUE_ACTIVE ||
+            (dio && (s->drive != GPIOD_LINE_DRIVE_OPEN_DRAIN ||
+                     s->bias != GPIOD_LINE_BIAS_PULL_UP)) ||
+            (!dio && s->drive == GPIOD_LINE_DRIVE_OPEN_DRAIN)) {
+            sim.errors++;
+        }
+        sim.request.requested[n] = true;
+        sim.level[n] = 1;
+    }
+    return &sim.request;
+}
+
+struct gpiod_line_settings *gpiod_line_settings_new(void)
+{
+    struct gpiod_line_settings *settings = calloc(1, sizeof(*settings));
+    if (settings) {
+        settings->direction = GPIOD_LINE_DIRECTION_AS_IS;
+        settings->drive = GPIOD_LINE_DRIVE_PUSH_PULL;
+        settings->bias = GPIOD_LINE_BIAS_AS_IS;
+    }
+    return settings;
+}
+
+void gpiod_line_settings_free(struct gpiod_line_settings *settings)
+{
+    free(settings);
+}
+
+int gpiod_line_settings_set_direction(struct gpiod_line_settings *settings,
+                                      enum gpiod_line_direction direction)
+{
+    settings->direction = direction;
+    return 0;
+}
+
+int gpiod_line_settings_set_output_value(struct gpiod_line_settings *settings,
+                                         enum gpiod_line_value value)
+{
+    settings->value = value;
+    return 0;
+}
+
+int gpiod_line_settings_set_drive(struct gpiod_line_settings *settings,
+                                  enum gpiod_line_drive drive)
+{
+    settings->drive = drive;
+    return 0;
+}
+
+int gpiod_line_settings_set_bias(struct gpiod_line_settings *settings,
+                                 enum gpiod_line_bias bias)
+{
+    settings->bias = bias;
+    return 0;
+}
+
+struct gpiod_line_config *gpiod_line_config_new(void)
+{
+    return calloc(1, sizeof(struct gpiod_line_config));
+}
+
+void gpiod_line_config_free(struct gpiod_line_config *config)
+{
+    free(config);
+}
+
+int gpiod_line_config_add_line_settings(struct gpiod_line_config *config,
+                                        const unsigned int *offsets,
+                                        size_t num_offsets,
+                                        struct gpiod_line_settings *settings)
+{
+    for (size_t n = 0; n < num_offsets; n++) {
+        if (offsets[n] >= LINES) {
+            errno = EINVAL;
+            return -1;
+        }
+        config->set[offsets[n]] = true;
+        config->settings[offsets[n]] = *settings;
+    }
+    return 0;
+}
+
+struct gpiod_request_config *gpiod_request_config_new(void)
+{
+    return calloc(1, sizeof(struct gpiod_request_config));
+}
+
+void gpiod_request_config_free(struct gpiod_request_config *config)
+{
+    free(config);
+}
+
+void gpiod_request_config_set_consumer(struct gpiod_request_config *config,
+                                       const char *consumer)
+{
+    (void)config;
+    (void)consumer;
+}
+
+void gpiod_line_request_release(struct gpiod_line_request *request)
+{
+    memset(request, 0, sizeof(*request));
+}
+
+enum gpiod_line_value
+gpiod_line_request_get_value(struct gpiod_line_request *request,
+                             unsigned int offset)
+{
+    if (offset >= LINES || !request->requested[offset]) {
+        errno = EINVAL;
+        return GPIOD_LINE_VALUE_ERROR;
+    }
+    int level = sim.level[offset];
+    if (offset == sim.dio) {
+        /* Open drain: any chip driving low pulls the line low. */
+        for (size_t i = 0; i < sim.chip_num; i++) {
+            level &= sim.chips[i].dio;
+        }
+    }
+    return level ? GPIOD_LINE_VALUE_ACTIVE : GPIOD_LINE_VALUE_INACTIVE;
+}
+
+int gpiod_line_request_set_values_subset(struct gpiod_line_request *request,
+                                         size_t num_values,
+                                         const unsigned int *offsets,
+                                         const enum gpiod_line_value *values)
+{
+    int old[LINES];
+    memcpy(old, sim.level, sizeof(old));
+    for (size_t n = 0; n < num_values; n++) {
+        if (offsets[n] >= LINES || !request->requested[offsets[n]]) {
+            errno = EINVAL;
+            return -1;
+        }
+        sim.level[offsets[n]] = values[n] == GPIOD_LINE_VALUE_ACTIVE;
+    }
+    _update(old);
+    return 0;
+}
+
+int gpiod_line_request_set_value(struct gpiod_line_request *request,
+                                 unsigned int offset,
+                                 enum gpiod_line_value value)
+{
+    return gpiod_line_request_set_values_subset(request, 1, &offset, &value);
+}
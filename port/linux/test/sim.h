@@ -0,0 +1,69 @@
+/**
+ * @file sim.h
+ * @brief Simulated TM1668 / TM1638 chips behind the fake libgpiod.
+ *
+ * gpiod_sim.c keeps the level of every line and decodes the waveform the
+ * backend drives: each chip latches DIO on rising CLK edges while its STB
+ * is low, executes the commands and display writes it receives, and after
+ * READ_KEY shifts its key bytes out on DIO at falling CLK edges. Protocol
+ * violations (DIO changing with a rising CLK edge, DIO driven low while
+ * the chip outputs, partial bytes, misrequested lines) are counted.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Path that gpiod_chip_open() accepts. */
+#define SIM_CHIP_PATH "/dev/gpiochip-sim"
+
+/** Frames a chip logs, oldest first. */
+#define SIM_LOG_MAX 32
+
+/** Bytes logged per frame. */
+#define SIM_FRAME_MAX 24
+
+/**
+ * @brief One STB frame as the chip received it.
+ */
+typedef struct {
+    uint8_t bytes[SIM_FRAME_MAX]; /**< Bytes written by the host */
+    size_t len;                   /**< Number of bytes */
+} sim_frame_t;
+
+/**
+ * @brief State of one simulated chip.
+ */
+typedef struct {
+    uint8_t display[16];          /**< Display RAM */
+    uint8_t keys[5];              /**< Key data returned by READ_KEY */
+    uint8_t mode;                 /**< Last display mode command */
+    uint8_t control;              /**< Last display control command */
+    bool address_fixed;           /**< Fixed-address writes selected */
+    sim_frame_t log[SIM_LOG_MAX]; /**< Received frames */
+    size_t frames;                /**< Number of logged frames */
+} sim_chip_t;
+
+/**
+ * @brief Wire the simulated chips: shared CLK and DIO, one STB each.
+ *
+ * Resets all chips and line levels.
+ *
+ * @param[in] clk CLK line offset.
+ * @param[in] dio DIO line offset.
+ * @param[in] stb STB line offset of each chip.
+ * @param[in] num Number of chips.
+ */
+void sim_wire(unsigned int clk, unsigned int dio, const unsigned int *stb,
+              size_t num);
+
+/** Chip wired to the index-th STB line. */
+sim_chip_t *sim_chip(size_t index);
+
+/** Forget the frames logged so far by every chip. */
+void sim_clear_log(void);
+
+/** Number of protocol violations seen since sim_wire(). */
+int sim_errors(void);
@@ -0,0 +1,127 @@
+/*
+ * Test of the Linux backend on the kernel's gpio-sim, through the real
+ * libgpiod and GPIO character device. gpio-sim cannot answer as a chip, so
+ * this checks what the kernel side can show: the line request (idle
+ * levels, open-drain DIO), that every transaction leaves the lines idle,
+ * and key reads following the simulated pull on the released DIO line.
+ * The protocol itself is checked by test_tm1668_linux.
+ *
+ * Usage: test_tm1668_linux_gpio_sim <chip> <sim sysfs dir>
+ *   normally run by gpio_sim.sh, which creates the simulated chip.
+ */
+
+#include "tm1668_linux.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures;
+
+#define CHECK(cond)                                                            \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,   \
+                    #cond);                                                    \
+            failures++;                                                        \
+        }                                                                      \
+    } while (0)
+
+enum { CLK = 0, DIO = 1 };
+static const unsigned int stb[] = {2, 3};
+
+static const char *sim_dir;
+
+/** Level of a simulated line as the kernel sees it, or -1. */
+static int sim_value(unsigned int offset)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/sim_gpio%u/value", sim_dir, offset);
+    FILE *f = fopen(path, "r");
+    int value = -1;
+    if (f) {
+        if (fscanf(f, "%d", &value) != 1) {
+            value = -1;
+        }
+        fclose(f);
+    }
+    return value;
+}
+
+/** Set the simulated pull of a line ("pull-up" or "pull-down"). */
+static int sim_pull(unsigned int offset, const char *pull)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/sim_gpio%u/pull", sim_dir, offset);
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        return -1;
+    }
+    int ret = fputs(pull, f) < 0 ? -1 : 0;
+    return fclose(f) ? -1 : ret;
+}
+
+/** true if CLK, DIO and every STB line are idle (high). */
+static bool lines_idle(void)
+{
+    bool idle = sim_value(CLK) == 1 && sim_value(DIO) == 1;
+    for (size_t i = 0; i < sizeof(stb) / sizeof(stb[0]); i++) {
+        idle = idle && sim_value(stb[i]) == 1;
+    }
+    return idle;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <chip> <sim sysfs dir>\n", argv[0]);
+        return 2;
+    }
+    sim_dir = argv[2];
+    const tm1668_linux_config_t config = {
+        .chip_path = argv[1],
+        .clk_offset = CLK,
+        .dio_offset = DIO,
+        .stb_offsets = stb,
+        .device_num = 2,
+        .timing = TM1668_LINUX_TIMING_DEFAULT,
+    };
+
+    /* The released DIO line reads the pull; start with the idle level. */
+    CHECK(sim_pull(DIO, "pull-up") == 0);
+    tm1668_linux_handle_t handle;
+    if (tm1668_linux_open(&config, &handle) != 0) {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+    CHECK(lines_idle());
+
+    uint8_t frame[16];
+    for (size_t n = 0; n < sizeof(frame); n++) {
+        frame[n] = 0x55 ^ n;
+    }
+    CHECK(tm1668_linux_display_auto(handle, 0, 0, frame, sizeof(frame)) == 0);
+    CHECK(tm1668_linux_display_fixed(handle, 1, 3, 0x00) == 0);
+    CHECK(tm1668_linux_set_pulse(handle, 1, 7) == 0);
+    CHECK(tm1668_linux_display(handle, 0, true) == 0);
+    CHECK(lines_idle());
+
+    uint8_t keys[5];
+    CHECK(tm1668_linux_read_key(handle, 0, keys, sizeof(keys)) == 0);
+    for (size_t n = 0; n < sizeof(keys); n++) {
+        CHECK(keys[n] == 0xFF);
+    }
+    CHECK(sim_pull(DIO, "pull-down") == 0);
+    CHECK(tm1668_linux_read_key(handle, 1, keys, 4) == 0);
+    for (int n = 0; n < 4; n++) {
+        CHECK(keys[n] == 0x00);
+    }
+    CHECK(sim_pull(DIO, "pull-up") == 0);
+    CHECK(lines_idle());
+
+    /* The lines are released and can be requested again. */
+    tm1668_linux_close(handle);
+    CHECK(tm1668_linux_open(&config, &handle) == 0);
+    tm1668_linux_close(handle);
+
+    printf("%s\n", failures ? "FAIL" : "OK");
+    return failures != 0;
+}
@@ -0,0 +1,184 @@
+/*
+ * Host test of the Linux backend against simulated chips: builds
+ * tm1668_linux.c on the fake libgpiod in this directory and checks the
+ * frames, the chip state they produce and the key data read back.
+ *
+ * Usage: test_tm1668_linux (exit status 0 on success)
+ */
+
+#include "sim.h"
+#include "tm1668_linux.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+static int failures;
+
+#define CHECK(cond)                                                            \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,   \
+                    #cond);                                                    \
+            failures++;                                                        \
+        }                                                                      \
+    } while (0)
+
+/** Check that frame n of a chip holds exactly the given bytes. */
+#define CHECK_FRAME(chip, n, ...)                                              \
+    do {                                                                       \
+        const uint8_t expect[] = {__VA_ARGS__};                                \
+        CHECK((chip)->frames > (n));                                           \
+        CHECK((chip)->log[n].len == sizeof(expect));                           \
+        CHECK(memcmp((chip)->log[n].bytes, expect, sizeof(expect)) == 0);      \
+    } while (0)
+
+enum { CLK = 1, DIO = 2 };
+static const unsigned int stb[] = {3, 4};
+
+static tm1668_linux_handle_t open_sim(void)
+{
+    const tm1668_linux_config_t config = {
+        .chip_path = SIM_CHIP_PATH,
+        .clk_offset = CLK,
+        .dio_offset = DIO,
+        .stb_offsets = stb,
+        .device_num = 2,
+        .timing = {0},
+    };
+    tm1668_linux_handle_t handle = NULL;
+    sim_wire(CLK, DIO, stb, 2);
+    CHECK(tm1668_linux_open(&config, &handle) == 0);
+    return handle;
+}
+
+/** Close the handle; the chips must not have seen a protocol violation. */
+static void close_sim(tm1668_linux_handle_t handle)
+{
+    tm1668_linux_close(handle);
+    CHECK(sim_errors() == 0);
+}
+
+static void test_display_auto(void)
+{
+    tm1668_linux_handle_t handle = open_sim();
+    sim_chip_t *chip = sim_chip(0);
+
+    const uint8_t data[] = {0x11, 0x22, 0x33};
+    CHECK(tm1668_linux_display_auto(handle, 0, 2, data, sizeof(data)) == 0);
+    CHECK(chip->frames == 1);
+    CHECK_FRAME(chip, 0, 0xC2, 0x11, 0x22, 0x33);
+    CHECK(memcmp(&chip->display[2], data, sizeof(data)) == 0);
+    /* The other device's STB stays high. */
+    CHECK(sim_chip(1)->frames == 0);
+
+    close_sim(handle);
+}
+
+static void test_display_fixed(void)
+{
+    tm1668_linux_handle_t handle = open_sim();
+    sim_chip_t *chip = sim_chip(1);
+
+    /* The first fixed write switches the addressing, later ones do not. */
+    CHECK(tm1668_linux_display_fixed(handle, 1, 5, 0xA5) == 0);
+    CHECK(tm1668_linux_display_fixed(handle, 1, 9, 0x5A) == 0);
+    CHECK(chip->frames == 3);
+    CHECK_FRAME(chip, 0, 0x44);
+    CHECK_FRAME(chip, 1, 0xC5, 0xA5);
+    CHECK_FRAME(chip, 2, 0xC9, 0x5A);
+    CHECK(chip->display[5] == 0xA5 && chip->display[9] == 0x5A);
+
+    /* Back to auto-increment for a burst. */
+    sim_clear_log();
+    const uint8_t data[] = {1, 2};
+    CHECK(tm1668_linux_display_auto(handle, 1, 14, data, sizeof(data)) == 0);
+    CHECK(chip->frames == 2);
+    CHECK_FRAME(chip, 0, 0x40);
+    CHECK_FRAME(chip, 1, 0xCE, 1, 2);
+    CHECK(chip->display[14] == 1 && chip->display[15] == 2);
+
+    /* reset() returns to auto-increment and is remembered. */
+    CHECK(tm1668_linux_display_fixed(handle, 1, 0, 0xFF) == 0);
+    CHECK(tm1668_linux_reset(handle, 1) == 0);
+    sim_clear_log();
+    CHECK(tm1668_linux_display_auto(handle, 1, 0, data, 1) == 0);
+    CHECK(chip->frames == 1);
+    CHECK_FRAME(chip, 0, 0xC0, 1);
+
+    close_sim(handle);
+}
+
+static void test_commands(void)
+{
+    tm1668_linux_handle_t handle = open_sim();
+    sim_chip_t *chip = sim_chip(0);
+
+    CHECK(tm1668_linux_set_mode(handle, 0, 3) == 0);
+    CHECK(chip->mode == 3);
+    CHECK_FRAME(chip, 0, 0x03);
+
+    /* Pulse width and on/off are kept across each other; width masked. */
+    CHECK(tm1668_linux_set_pulse(handle, 0, 2) == 0);
+    CHECK(chip->control == 0x82);
+    CHECK(tm1668_linux_display(handle, 0, true) == 0);
+    CHECK(chip->control == 0x8A);
+    CHECK(tm1668_linux_set_pulse(handle, 0, 0xF) == 0);
+    CHECK(chip->control == 0x8F);
+    CHECK(tm1668_linux_display(handle, 0, false) == 0);
+    CHECK(chip->control == 0x87);
+
+    close_sim(handle);
+}
+
+static void test_read_key(void)
+{
+    tm1668_linux_handle_t handle = open_sim();
+    const uint8_t keys[] = {0x12, 0x34, 0x56, 0x78, 0x9A};
+    memcpy(sim_chip(1)->keys, keys, sizeof(keys));
+
+    uint8_t data[5];
+    CHECK(tm1668_linux_read_key(handle, 1, data, sizeof(data)) == 0);
+    CHECK(memcmp(data, keys, sizeof(keys)) == 0);
+    CHECK_FRAME(sim_chip(1), 0, 0x42);
+
+    /* Another chip on the same DIO does not disturb the scan. */
+    CHECK(tm1668_linux_read_key(handle, 0, data, 4) == 0);
+    CHECK(data[0] == 0 && data[3] == 0);
+
+    close_sim(handle);
+}
+
+static void test_invalid(void)
+{
+    tm1668_linux_handle_t handle = open_sim();
+    uint8_t data[6] = {0};
+
+    CHECK(tm1668_linux_display_auto(handle, 2, 0, data, 1) == -EINVAL);
+    CHECK(tm1668_linux_display_auto(handle, 0, 15, data, 2) == -EINVAL);
+    CHECK(tm1668_linux_display_fixed(handle, 0, 16, 0) == -EINVAL);
+    CHECK(tm1668_linux_read_key(handle, 0, data, 0) == -EINVAL);
+    CHECK(tm1668_linux_read_key(handle, 0, data, 6) == -EINVAL);
+    CHECK(tm1668_linux_set_pulse(NULL, 0, 0) == -EINVAL);
+    CHECK(sim_chip(0)->frames == 0);
+    close_sim(handle);
+
+    const tm1668_linux_config_t config = {
+        .chip_path = "/dev/gpiochip-missing",
+        .clk_offset = CLK,
+        .dio_offset = DIO,
+        .stb_offsets = stb,
+        .device_num = 1,
+    };
+    CHECK(tm1668_linux_open(&config, &handle) == -ENOENT);
+}
+
+int main(void)
+{
+    test_display_auto();
+    test_display_fixed();
+    test_commands();
+    test_read_key();
+    test_invalid();
+    printf("%s\n", failures ? "FAIL" : "OK");
+    return failures != 0;
+}
@@ -0,0 +1,390 @@
+/**
+ * @file tm1668_linux.c
+ * @brief TM1668 / TM1638 protocol on Linux through libgpiod (v2).
+ *
+ * Each bit costs two ioctls: one set_values call that drives CLK low and
+ * puts the bit on DIO, and one that raises CLK (the chip latches DIO on
+ * the rising edge). A per-line port needs three writes per bit, and sysfs
+ * additionally pays a file write and value parse for each.
+ *
+ * Command bytes and frame layout come from src/tm1668_proto.h, shared with
+ * the ESP-IDF driver; every transaction is one _frame() of command and data
+ * bytes plus optional key bytes, like tm1668_engine_frame() there. Only the
+ * line access below is Linux specific.
+ */
+
+#include "tm1668_linux.h"
+#include "tm1668_proto.h"
+#include <errno.h>
+#include <gpiod.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** Index of CLK and DIO in clk_dio. */
+enum { LINE_CLK, LINE_DIO };
+
+/**
+ * @brief Per-device protocol state.
+ */
+struct tm1668_linux_dev_t {
+    unsigned int stb_offset; /**< STB line offset */
+    uint8_t pulse_width;     /**< Last pulse width */
+    bool display_on;         /**< Last on/off state */
+    bool address_fixed;      /**< Device is in fixed-address mode */
+};
+
+/**
+ * @brief Internal handle structure.
+ */
+struct tm1668_linux_t {
+    struct gpiod_line_request *request; /**< CLK, DIO and all STB lines */
+    unsigned int clk_dio[2];            /**< Offsets of CLK and DIO */
+    tm1668_linux_timing_t timing;       /**< Serial timing */
+    pthread_mutex_t lock;               /**< Serializes transactions */
+    size_t device_num;                  /**< Number of devices */
+    struct tm1668_linux_dev_t devices[TM1668_LINUX_MAX_DEVICES];
+};
+
+/** Busy-wait; sleeping would cost far more than the delays involved. */
+static void _delay_us(uint32_t us)
+{
+    if (!us) {
+        return;
+    }
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    } while ((now.tv_sec - start.tv_sec) * 1000000000L +
+                 (now.tv_nsec - start.tv_nsec) <
+             (long)us * 1000);
+}
+
+/** Drive CLK and DIO with one ioctl. */
+static int _set_clk_dio(tm1668_linux_handle_t handle, int clk, int dio)
+{
+    const enum gpiod_line_value values[2] = {
+        clk ? GPIOD_LINE_VALUE_ACTIVE : GPIOD_LINE_VALUE_INACTIVE,
+        dio ? GPIOD_LINE_VALUE_ACTIVE : GPIOD_LINE_VALUE_INACTIVE,
+    };
+    return gpiod_line_request_set_values_subset(handle->request, 2,
+                                                handle->clk_dio, values) < 0
+               ? -errno
+               : 0;
+}
+
+/** Drive a single line. */
+static int _set_line(tm1668_linux_handle_t handle, unsigned int offset,
+                     int level)
+{
+    return gpiod_line_request_set_value(handle->request, offset,
+                                        level ? GPIOD_LINE_VALUE_ACTIVE
+                                              : GPIOD_LINE_VALUE_INACTIVE) < 0
+               ? -errno
+               : 0;
+}
+
+/**
+ * @brief Send one byte, LSB first; CLK ends high and DIO released.
+ */
+static int _send_data(tm1668_linux_handle_t handle, uint8_t value)
+{
+    int ret;
+    for (int b = 0; b < 8; b++) {
+        if ((ret = _set_clk_dio(handle, 0, (value >> b) & 1)) < 0) {
+            return ret;
+        }
+        _delay_us(handle->timing.delay_us);
+        if ((ret = _set_clk_dio(handle, 1, (value >> b) & 1)) < 0) {
+            return ret;
+        }
+        _delay_us(handle->timing.delay_us);
+    }
+    return _set_clk_dio(handle, 1, 1);
+}
+
+/**
+ * @brief Clock in key bytes, LSB first; DIO is already released.
+ */
+static int _read_data(tm1668_linux_handle_t handle, uint8_t *data,
+                      size_t size)
+{
+    unsigned int dio = handle->clk_dio[LINE_DIO];
+    int ret;
+    for (size_t n = 0; n < size; n++) {
+        data[n] = 0;
+        for (int b = 0; b < 8; b++) {
+            if ((ret = _set_clk_dio(handle, 0, 1)) < 0) {
+                return ret;
+            }
+            _delay_us(handle->timing.delay_us);
+            if ((ret = _set_clk_dio(handle, 1, 1)) < 0) {
+                return ret;
+            }
+            _delay_us(handle->timing.delay_us);
+            enum gpiod_line_value v =
+                gpiod_line_request_get_value(handle->request, dio);
+            if (v == GPIOD_LINE_VALUE_ERROR) {
+                return -errno;
+            }
+            data[n] |= (v == GPIOD_LINE_VALUE_ACTIVE) << b;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Send one frame: STB low, tx bytes, rx key bytes, STB high.
+ *
+ * The first tx byte is the command. With rx_len > 0 it must be READ_KEY;
+ * the key bytes are clocked in after the settling delay. STB is raised
+ * even if a line update fails, so the chip never stays selected. Caller
+ * holds handle->lock.
+ */
+static int _frame(tm1668_linux_handle_t handle, size_t dev, const uint8_t *tx,
+                  size_t tx_len, uint8_t *rx, size_t rx_len)
+{
+    unsigned int stb = handle->devices[dev].stb_offset;
+    int ret = _set_line(handle, stb, 0);
+    for (size_t n = 0; ret == 0 && n < tx_len; n++) {
+        ret = _send_data(handle, tx[n]);
+    }
+    if (ret == 0 && rx_len) {
+        _delay_us(handle->timing.read_key_delay_us);
+        ret = _read_data(handle, rx, rx_len);
+    }
+    int end = _set_line(handle, stb, 1);
+    return ret < 0 ? ret : end;
+}
+
+/** Send a command byte alone. Caller holds handle->lock. */
+static int _command_frame(tm1668_linux_handle_t handle, size_t dev,
+                          uint8_t command)
+{
+    return _frame(handle, dev, &command, 1, NULL, 0);
+}
+
+static int _command(tm1668_linux_handle_t handle, size_t dev, uint8_t command)
+{
+    if (!handle || dev >= handle->device_num) {
+        return -EINVAL;
+    }
+    pthread_mutex_lock(&handle->lock);
+    int ret = _command_frame(handle, dev, command);
+    pthread_mutex_unlock(&handle->lock);
+    return ret;
+}
+
+/** Display control command of a device. Caller holds handle->lock. */
+static int _display_control(tm1668_linux_handle_t handle, size_t dev)
+{
+    const struct tm1668_linux_dev_t *d = &handle->devices[dev];
+    return _command_frame(handle, dev,
+                          DISPLAY_CONTROL_COMMAND(d->display_on,
+                                                  d->pulse_width));
+}
+
+/**
+ * @brief Write display bytes in the requested address mode.
+ *
+ * Switches the device's addressing first if needed (cached), then sends
+ * the address command and the data in one frame. Caller holds
+ * handle->lock.
+ */
+static int _display_frame(tm1668_linux_handle_t handle, size_t dev,
+                          bool fixed, uint8_t address, const uint8_t *data,
+                          size_t size)
+{
+    struct tm1668_linux_dev_t *d = &handle->devices[dev];
+    if (d->address_fixed != fixed) {
+        int ret = _command_frame(handle, dev, DATA_COMMAND(fixed));
+        if (ret < 0) {
+            return ret;
+        }
+        d->address_fixed = fixed;
+    }
+    if (!size) {
+        return 0;
+    }
+    uint8_t tx[1 + DISPLAY_RAM_SIZE];
+    tx[0] = ADDRESS_COMMAND(address);
+    memcpy(&tx[1], data, size);
+    return _frame(handle, dev, tx, 1 + size, NULL, 0);
+}
+
+int tm1668_linux_open(const tm1668_linux_config_t *config,
+                      tm1668_linux_handle_t *ret_handle)
+{
+    if (!config || !config->chip_path || !ret_handle ||
+        !config->stb_offsets || config->device_num == 0 ||
+        config->device_num > TM1668_LINUX_MAX_DEVICES ||
+        config->clk_offset == config->dio_offset) {
+        return -EINVAL;
+    }
+
+    tm1668_linux_handle_t handle = calloc(1, sizeof(struct tm1668_linux_t));
+    if (!handle) {
+        return -ENOMEM;
+    }
+    handle->clk_dio[LINE_CLK] = config->clk_offset;
+    handle->clk_dio[LINE_DIO] = config->dio_offset;
+    handle->timing = config->timing;
+    handle->device_num = config->device_num;
+    unsigned int push_pull[1 + TM1668_LINUX_MAX_DEVICES];
+    push_pull[0] = config->clk_offset;
+    for (size_t i = 0; i < config->device_num; i++) {
+        handle->devices[i].stb_offset = config->stb_offsets[i];
+        push_pull[1 + i] = config->stb_offsets[i];
+    }
+
+    int ret = -ENOMEM;
+    struct gpiod_chip *chip = NULL;
+    struct gpiod_line_settings *settings = gpiod_line_settings_new();
+    struct gpiod_line_config *line_config = gpiod_line_config_new();
+    struct gpiod_request_config *request_config = gpiod_request_config_new();
+    if (!settings || !line_config || !request_config) {
+        goto out;
+    }
+
+    /* Everything idles high; DIO is open-drain so the chip can drive it. */
+    gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_OUTPUT);
+    gpiod_line_settings_set_output_value(settings, GPIOD_LINE_VALUE_ACTIVE);
+    if (gpiod_line_config_add_line_settings(line_config, push_pull,
+                                            1 + config->device_num,
+                                            settings) < 0) {
+        ret = -errno;
+        goto out;
+    }
+    gpiod_line_settings_set_drive(settings, GPIOD_LINE_DRIVE_OPEN_DRAIN);
+    gpiod_line_settings_set_bias(settings, GPIOD_LINE_BIAS_PULL_UP);
+    if (gpiod_line_config_add_line_settings(line_config, &config->dio_offset,
+                                            1, settings) < 0) {
+        ret = -errno;
+        goto out;
+    }
+    gpiod_request_config_set_consumer(
+        request_config, config->consumer ? config->consumer : "tm1668");
+
+    chip = gpiod_chip_open(config->chip_path);
+    if (!chip) {
+        ret = -errno;
+        goto out;
+    }
+    handle->request =
+        gpiod_chip_request_lines(chip, request_config, line_config);
+    if (!handle->request) {
+        ret = -errno;
+        goto out;
+    }
+
+    pthread_mutex_init(&handle->lock, NULL);
+    *ret_handle = handle;
+    ret = 0;
+
+out:
+    /* The line request stays valid without the chip. */
+    if (chip) {
+        gpiod_chip_close(chip);
+    }
+    gpiod_request_config_free(request_config);
+    gpiod_line_config_free(line_config);
+    gpiod_line_settings_free(settings);
+    if (ret < 0) {
+        free(handle);
+    }
+    return ret;
+}
+
+void tm1668_linux_close(tm1668_linux_handle_t handle)
+{
+    if (!handle) {
+        return;
+    }
+    gpiod_line_request_release(handle->request);
+    pthread_mutex_destroy(&handle->lock);
+    free(handle);
+}
+
+int tm1668_linux_reset(tm1668_linux_handle_t handle, size_t dev)
+{
+    int ret = _command(handle, dev, DATA_COMMAND(false));
+    if (ret == 0) {
+        pthread_mutex_lock(&handle->lock);
+        handle->devices[dev].address_fixed = false;
+        pthread_mutex_unlock(&handle->lock);
+    }
+    return ret;
+}
+
+int tm1668_linux_set_mode(tm1668_linux_handle_t handle, size_t dev,
+                          uint8_t mode)
+{
+    return _command(handle, dev, MODE_COMMAND(mode));
+}
+
+int tm1668_linux_set_pulse(tm1668_linux_handle_t handle, size_t dev,
+                           uint8_t width)
+{
+    if (!handle || dev >= handle->device_num) {
+        return -EINVAL;
+    }
+    pthread_mutex_lock(&handle->lock);
+    handle->devices[dev].pulse_width = PULSE_WIDTH_MASK & width;
+    int ret = _display_control(handle, dev);
+    pthread_mutex_unlock(&handle->lock);
+    return ret;
+}
+
+int tm1668_linux_display(tm1668_linux_handle_t handle, size_t dev, bool on)
+{
+    if (!handle || dev >= handle->device_num) {
+        return -EINVAL;
+    }
+    pthread_mutex_lock(&handle->lock);
+    handle->devices[dev].display_on = on;
+    int ret = _display_control(handle, dev);
+    pthread_mutex_unlock(&handle->lock);
+    return ret;
+}
+
+int tm1668_linux_display_auto(tm1668_linux_handle_t handle, size_t dev,
+                              uint8_t address, const uint8_t *data,
+                              size_t size)
+{
+    if (!handle || dev >= handle->device_num || !data ||
+        address >= DISPLAY_RAM_SIZE || size > (size_t)(DISPLAY_RAM_SIZE - address)) {
+        return -EINVAL;
+    }
+    pthread_mutex_lock(&handle->lock);
+    int ret = _display_frame(handle, dev, false, address, data, size);
+    pthread_mutex_unlock(&handle->lock);
+    return ret;
+}
+
+int tm1668_linux_display_fixed(tm1668_linux_handle_t handle, size_t dev,
+                               uint8_t address, uint8_t data)
+{
+    if (!handle || dev >= handle->device_num || address >= DISPLAY_RAM_SIZE) {
+        return -EINVAL;
+    }
+    pthread_mutex_lock(&handle->lock);
+    int ret = _display_frame(handle, dev, true, address, &data, 1);
+    pthread_mutex_unlock(&handle->lock);
+    return ret;
+}
+
+int tm1668_linux_read_key(tm1668_linux_handle_t handle, size_t dev,
+                          uint8_t *data, size_t size)
+{
+    if (!handle || dev >= handle->device_num || !data || size == 0 ||
+        size > KEY_SIZE_MAX) {
+        return -EINVAL;
+    }
+    const uint8_t command = READ_KEY;
+    pthread_mutex_lock(&handle->lock);
+    int ret = _frame(handle, dev, &command, 1, data, size);
+    pthread_mutex_unlock(&handle->lock);
+    return ret;
+}
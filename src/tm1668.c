@@ -26,6 +26,8 @@
  * or clone chips that require slower timing.
  * CONFIG_TM1668_READ_KEY_DELAY_US is the settling time after the READ_KEY
  * command before the TM1668 begins driving DIO (default 2 us).
+ * These are only the defaults: each bus keeps its own timing, which
+ * tm1668_set_timing() and tm1668_calibrate() change at run time.
  */
 
 #include "tm1668.h"
@@ -34,64 +36,22 @@
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
-#ifdef CONFIG_TM1668_WITH_BUS
-#include <sys/queue.h>
-#endif
+#include "tm1638.h"
+#include "tm1668_priv.h"
+#include <string.h>
 
 static const char TAG[] = "tm1668";
 
 #ifdef CONFIG_TM1668_WITH_BUS
-/** Singly-linked list entry for a device on a shared bus. */
-typedef struct tm1668_bus_device_list {
-    tm1668_dev_handle_t device;
-    SLIST_ENTRY(tm1668_bus_device_list) next;
-} tm1668_bus_device_list_t;
-
-/**
- * @brief Internal bus structure.
- */
-struct tm1668_bus_t {
-    gpio_num_t clk_num;             /**< Shared CLK GPIO pin */
-    gpio_num_t dio_num;             /**< Shared DIO GPIO pin (open-drain) */
-    SemaphoreHandle_t bus_lock_mux; /**< Mutex for device list access */
-    SLIST_HEAD(tm1668_bus_device_list_head, tm1668_bus_device_list)
-    device_list; /**< List of devices on this bus */
-};
-
-/** Dereference the bus handle from a device handle. */
-#define BUS_HANDLE(p) ((p)->bus_handle)
-
-#else
-/** In non-bus mode, the bus handle IS the device handle. */
-typedef tm1668_dev_handle_t tm1668_bus_handle_t;
-
-#define BUS_HANDLE(p) (p)
-#endif
-
-/**
- * @brief Internal device structure.
- */
-struct tm1668_dev_t {
-#ifdef CONFIG_TM1668_WITH_BUS
-    tm1668_bus_handle_t bus_handle; /**< Owning bus handle (bus mode) */
-#else
-    gpio_num_t clk_num; /**< CLK GPIO pin (standalone mode) */
-    gpio_num_t dio_num; /**< DIO GPIO pin (standalone mode) */
+_Static_assert(sizeof(tm1668_bus_static_t) >= sizeof(struct tm1668_bus_t),
+               "TM1668_BUS_STATIC_WORDS is too small");
+_Static_assert(sizeof(tm1668_dev_static_t) >= sizeof(struct tm1668_dev_t),
+               "TM1668_DEV_STATIC_WORDS is too small");
 #endif
-    gpio_num_t stb_num;  /**< STB (strobe) GPIO pin */
-    bool address_fixed;  /**< true if device is in fixed-address mode */
-    bool display_on;     /**< Display on/off state (cached) */
-    uint8_t pulse_width; /**< Current pulse width setting (cached) */
-};
 
-/**
- * @brief Global spinlock for protocol-level mutual exclusion.
- *
- * While the bus semaphore protects the device list, this spinlock
- * ensures that the STB → command/data → STB transaction sequence is
- * not interrupted by another task or ISR.
- */
-static portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;
+/* Protocol-level spinlock and urgent request count, see tm1668_priv.h. */
+portMUX_TYPE tm1668_lock = portMUX_INITIALIZER_UNLOCKED;
+volatile uint32_t tm1668_urgent;
 
 /**
  * @brief Initialize a single GPIO pin for TM1668 communication.
@@ -123,41 +83,135 @@ static esp_err_t _init_gpio(gpio_num_t pin, gpio_mode_t mode,
 }
 
 #ifdef CONFIG_TM1668_WITH_BUS
-esp_err_t tm1668_new_bus(const tm1668_bus_config_t *bus_config,
-                         tm1668_bus_handle_t *ret_bus_handle)
+/**
+ * @brief Initialize a set of GPIO pins with a single gpio_config() call.
+ *
+ * Same as _init_gpio() for every pin in `mask`; an empty mask is a no-op.
+ *
+ * @param mask          Bitmask of GPIO pin numbers.
+ * @param mode          GPIO mode shared by all pins.
+ * @param enable_pullup Whether to enable the internal pull-up resistors.
+ * @return ESP_OK on success, or the underlying GPIO error code.
+ */
+static esp_err_t _init_gpio_mask(uint64_t mask, gpio_mode_t mode,
+                                 bool enable_pullup)
 {
-    ESP_RETURN_ON_FALSE(bus_config, ESP_ERR_INVALID_ARG, TAG,
-                        "invalid bus config");
-    ESP_RETURN_ON_FALSE(GPIO_IS_VALID_GPIO(bus_config->clk_io_num),
-                        ESP_ERR_INVALID_ARG, TAG, "invalid CLK pin number");
-    ESP_RETURN_ON_FALSE(GPIO_IS_VALID_GPIO(bus_config->dio_io_num),
-                        ESP_ERR_INVALID_ARG, TAG, "invalid DIO pin number");
+    if (!mask) {
+        return ESP_OK;
+    }
+    for (uint64_t m = mask; m; m &= m - 1) {
+        esp_err_t ret = gpio_set_level(__builtin_ctzll(m), 1);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    const gpio_config_t conf = {
+        .intr_type = GPIO_INTR_DISABLE,
+        .mode = mode,
+        .pull_down_en = false,
+        .pull_up_en = enable_pullup ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE,
+        .pin_bit_mask = mask,
+    };
+    return gpio_config(&conf);
+}
+#endif // CONFIG_TM1668_WITH_BUS
+
+/**
+ * @brief Initialize the display shadow of a new device.
+ *
+ * Display RAM content is undefined at power-on, so every address starts
+ * out dirty: the first flush clears whatever the chip holds.
+ *
+ * @param handle Device handle (zero-filled).
+ */
+static void _init_buffer(tm1668_dev_handle_t handle)
+{
+    portMUX_INITIALIZE(&handle->buf_lock);
+    handle->dirty = 0xFFFF;
+    /* Mode unknown until tm1668_set_mode() (never, on a TM1638): send all. */
+    handle->used = 0xFFFF;
+    handle->seg_hi = 0xFF;
+    /* Counters idle at 3 (all ones): no key changes yet. */
+    handle->debounce.ct0 = UINT64_MAX;
+    handle->debounce.ct1 = UINT64_MAX;
+}
 
+#ifdef CONFIG_TM1668_WITH_BUS
+/**
+ * @brief Initialize a zeroed bus structure (shared by heap and static paths).
+ *
+ * @param bus_handle Bus storage, zero-filled by the caller.
+ * @param bus_config Bus configuration (already validated).
+ * @return ESP_OK on success, or the underlying GPIO error code.
+ */
+static esp_err_t _bus_init(tm1668_bus_handle_t bus_handle,
+                           const tm1668_bus_config_t *bus_config)
+{
     esp_err_t ret = ESP_OK;
-    tm1668_bus_handle_t bus_handle =
-        (tm1668_bus_handle_t)calloc(1, sizeof(struct tm1668_bus_t));
-    ESP_GOTO_ON_FALSE(bus_handle, ESP_ERR_NO_MEM, err, TAG,
-                      "no memory for bus");
     bus_handle->clk_num = bus_config->clk_io_num;
     bus_handle->dio_num = bus_config->dio_io_num;
-    bus_handle->bus_lock_mux = xSemaphoreCreateBinary();
-    ESP_GOTO_ON_FALSE(bus_handle->bus_lock_mux, ESP_ERR_NO_MEM, err, TAG,
-                      "No memory for binary semaphore");
+    /* Static semaphore storage lives inside the bus: no extra allocation. */
+    bus_handle->bus_lock_mux =
+        xSemaphoreCreateBinaryStatic(&bus_handle->bus_lock_buf);
+    STAILQ_INIT(&bus_handle->device_list);
+    bus_handle->stb_mask = 0;
+    bus_handle->timing = TIMING_DEFAULT;
+    bus_handle->defer_gpio = bus_config->flags.defer_gpio_init;
+    bus_handle->dio_push_pull = bus_config->flags.dio_push_pull;
+    if (bus_config->flags.enable_internal_pullup) {
+        bus_handle->pullup_mask =
+            (1ULL << bus_handle->clk_num) | (1ULL << bus_handle->dio_num);
+    }
     xSemaphoreGive(bus_handle->bus_lock_mux);
+    if (bus_handle->defer_gpio) {
+        return ESP_OK;
+    }
 
     /* CLK: push-pull output (host always drives this line). */
     ESP_GOTO_ON_ERROR(_init_gpio(bus_handle->clk_num, GPIO_MODE_OUTPUT,
                                  bus_config->flags.enable_internal_pullup),
                       err, TAG, "init CLK GPIO failed");
 
-    /* DIO: open-drain so the TM1668 can pull it low during key scan reads. */
-    ESP_GOTO_ON_ERROR(_init_gpio(bus_handle->dio_num, GPIO_MODE_INPUT_OUTPUT_OD,
+    /* DIO: open-drain so the TM1668 can pull it low during key scan reads
+     * (or push-pull outside them, see _set_dio_od()). */
+    ESP_GOTO_ON_ERROR(_init_gpio(bus_handle->dio_num, _dio_mode(bus_handle),
                                  bus_config->flags.enable_internal_pullup),
                       err, TAG, "init DIO GPIO failed");
+    return ESP_OK;
 
-    xSemaphoreTake(bus_handle->bus_lock_mux, portMAX_DELAY);
-    SLIST_INIT(&bus_handle->device_list);
-    xSemaphoreGive(bus_handle->bus_lock_mux);
+err:
+    vSemaphoreDelete(bus_handle->bus_lock_mux);
+    bus_handle->bus_lock_mux = NULL;
+    return ret;
+}
+
+/** Validate a bus configuration (shared by heap and static paths). */
+static esp_err_t _bus_check_config(const tm1668_bus_config_t *bus_config)
+{
+    ESP_RETURN_ON_FALSE(bus_config, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid bus config");
+    ESP_RETURN_ON_FALSE(GPIO_IS_VALID_GPIO(bus_config->clk_io_num),
+                        ESP_ERR_INVALID_ARG, TAG, "invalid CLK pin number");
+    ESP_RETURN_ON_FALSE(GPIO_IS_VALID_GPIO(bus_config->dio_io_num),
+                        ESP_ERR_INVALID_ARG, TAG, "invalid DIO pin number");
+    return ESP_OK;
+}
+
+esp_err_t tm1668_new_bus(const tm1668_bus_config_t *bus_config,
+                         tm1668_bus_handle_t *ret_bus_handle)
+{
+    ESP_RETURN_ON_ERROR(_bus_check_config(bus_config), TAG,
+                        "invalid bus config");
+    ESP_RETURN_ON_FALSE(ret_bus_handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid bus handle pointer");
+
+    esp_err_t ret = ESP_OK;
+    tm1668_bus_handle_t bus_handle =
+        (tm1668_bus_handle_t)calloc(1, sizeof(struct tm1668_bus_t));
+    ESP_GOTO_ON_FALSE(bus_handle, ESP_ERR_NO_MEM, err, TAG,
+                      "no memory for bus");
+    ESP_GOTO_ON_ERROR(_bus_init(bus_handle, bus_config), err, TAG,
+                      "init bus failed");
 
     *ret_bus_handle = bus_handle;
     return ESP_OK;
@@ -167,6 +221,27 @@ err:
     return ret;
 }
 
+esp_err_t tm1668_new_bus_static(const tm1668_bus_config_t *bus_config,
+                                tm1668_bus_static_t *bus_buffer,
+                                tm1668_bus_handle_t *ret_bus_handle)
+{
+    ESP_RETURN_ON_ERROR(_bus_check_config(bus_config), TAG,
+                        "invalid bus config");
+    ESP_RETURN_ON_FALSE(bus_buffer, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid bus buffer");
+    ESP_RETURN_ON_FALSE(ret_bus_handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid bus handle pointer");
+
+    tm1668_bus_handle_t bus_handle = (tm1668_bus_handle_t)bus_buffer;
+    memset(bus_handle, 0, sizeof(struct tm1668_bus_t));
+    bus_handle->is_static = true;
+    ESP_RETURN_ON_ERROR(_bus_init(bus_handle, bus_config), TAG,
+                        "init bus failed");
+
+    *ret_bus_handle = bus_handle;
+    return ESP_OK;
+}
+
 esp_err_t tm1668_del_bus(tm1668_bus_handle_t bus_handle)
 {
     ESP_RETURN_ON_FALSE(bus_handle, ESP_ERR_INVALID_ARG, TAG,
@@ -175,16 +250,19 @@ esp_err_t tm1668_del_bus(tm1668_bus_handle_t bus_handle)
     /* Clean up any devices still attached to this bus.
      * This is a safety net — callers should remove devices explicitly
      * with tm1668_bus_rm_device() before deleting the bus. */
-    if (!SLIST_EMPTY(&bus_handle->device_list)) {
+    if (!STAILQ_EMPTY(&bus_handle->device_list)) {
         int count = 0;
-        tm1668_bus_device_list_t *item, *tmp;
+        tm1668_dev_handle_t item, tmp;
         xSemaphoreTake(bus_handle->bus_lock_mux, portMAX_DELAY);
-        SLIST_FOREACH_SAFE(item, &bus_handle->device_list, next, tmp)
+        STAILQ_FOREACH_SAFE(item, &bus_handle->device_list, next, tmp)
         {
-            free(item->device);
-            free(item);
+            if (!item->is_static) {
+                free(item);
+            }
             count++;
         }
+        STAILQ_INIT(&bus_handle->device_list);
+        bus_handle->stb_mask = 0;
         xSemaphoreGive(bus_handle->bus_lock_mux);
         ESP_LOGW(TAG,
                  "bus deleted with %d device(s) still attached — "
@@ -195,91 +273,145 @@ esp_err_t tm1668_del_bus(tm1668_bus_handle_t bus_handle)
     if (bus_handle->bus_lock_mux) {
         vSemaphoreDelete(bus_handle->bus_lock_mux);
     }
-    free(bus_handle);
+    if (!bus_handle->is_static) {
+        free(bus_handle);
+    }
     return ESP_OK;
 }
 
-esp_err_t tm1668_bus_add_device(tm1668_bus_handle_t bus_handle,
-                                const tm1668_device_config_t *dev_config,
-                                tm1668_dev_handle_t *ret_handle)
+/**
+ * @brief Attach a zeroed device structure to a bus.
+ *
+ * The STB pin is reserved in the bus STB bitmask before the GPIO is
+ * configured, so the uniqueness check is O(1) and race-free.
+ *
+ * @param bus_handle Bus handle.
+ * @param dev_handle Device storage, zero-filled by the caller.
+ * @param dev_config Device configuration (already validated).
+ * @return
+ *  - ESP_OK on success.
+ *  - ESP_ERR_INVALID_ARG if the STB pin is already in use on this bus.
+ *  - The underlying GPIO error code if the STB pin cannot be configured.
+ */
+static esp_err_t _bus_attach(tm1668_bus_handle_t bus_handle,
+                             tm1668_dev_handle_t dev_handle,
+                             const tm1668_device_config_t *dev_config)
 {
-    ESP_RETURN_ON_FALSE(bus_handle, ESP_ERR_INVALID_ARG, TAG,
-                        "invalid bus handle");
-    ESP_RETURN_ON_FALSE(dev_config, ESP_ERR_INVALID_ARG, TAG,
-                        "invalid device config");
-    ESP_RETURN_ON_FALSE(GPIO_IS_VALID_GPIO(dev_config->stb_io_num),
-                        ESP_ERR_INVALID_ARG, TAG, "invalid STB pin number");
+    const uint64_t stb_bit = 1ULL << dev_config->stb_io_num;
 
-    /* Check that the STB pin is not already in use by another device. */
-    tm1668_bus_device_list_t *device_item;
-    bool stb_not_exist = true;
+    /* Reserve the STB pin (mutex-protected). */
     xSemaphoreTake(bus_handle->bus_lock_mux, portMAX_DELAY);
-    SLIST_FOREACH(device_item, &bus_handle->device_list, next)
-    {
-        if (device_item->device->stb_num == dev_config->stb_io_num) {
-            stb_not_exist = false;
-            break;
-        }
+    bool stb_not_exist = !(bus_handle->stb_mask & stb_bit);
+    bus_handle->stb_mask |= stb_bit;
+    if (stb_not_exist && dev_config->flags.enable_internal_pullup) {
+        bus_handle->pullup_mask |= stb_bit;
     }
     xSemaphoreGive(bus_handle->bus_lock_mux);
     ESP_RETURN_ON_FALSE(stb_not_exist, ESP_ERR_INVALID_ARG, TAG,
                         "STB pin is exist");
 
-    esp_err_t ret = ESP_OK;
-    tm1668_dev_handle_t dev_handle =
-        (tm1668_dev_handle_t)calloc(1, sizeof(struct tm1668_dev_t));
-    ESP_GOTO_ON_FALSE(dev_handle, ESP_ERR_NO_MEM, err, TAG,
-                      "no memory for device");
     dev_handle->bus_handle = bus_handle;
     dev_handle->stb_num = dev_config->stb_io_num;
     dev_handle->address_fixed = false;
     dev_handle->display_on = false;
     dev_handle->pulse_width = TM1668_PULSE_WIDTH_DEFAULT;
+    dev_handle->key_size =
+        dev_config->flags.tm1638 ? TM1638_KEY_SIZE : TM1668_KEY_SIZE;
+    _init_buffer(dev_handle);
+
+    /* STB: push-pull output (chip select, host always drives). */
+    esp_err_t ret = ESP_OK;
+    if (!bus_handle->defer_gpio) {
+        ret = _init_gpio(dev_handle->stb_num, GPIO_MODE_OUTPUT,
+                         dev_config->flags.enable_internal_pullup);
+    }
 
-    /* Insert into bus device list (mutex-protected). */
-    device_item =
-        (tm1668_bus_device_list_t *)calloc(1, sizeof(tm1668_bus_device_list_t));
-    ESP_GOTO_ON_FALSE((device_item != NULL), ESP_ERR_NO_MEM, err, TAG,
-                      "no memory for tm1668 device item");
-    device_item->device = dev_handle;
     xSemaphoreTake(bus_handle->bus_lock_mux, portMAX_DELAY);
-    SLIST_INSERT_HEAD(&bus_handle->device_list, device_item, next);
+    if (ret == ESP_OK) {
+        STAILQ_INSERT_TAIL(&bus_handle->device_list, dev_handle, next);
+    } else {
+        bus_handle->stb_mask &= ~stb_bit;
+        bus_handle->pullup_mask &= ~stb_bit;
+    }
     xSemaphoreGive(bus_handle->bus_lock_mux);
+    ESP_RETURN_ON_ERROR(ret, TAG, "init STB GPIO failed");
+    return ESP_OK;
+}
 
-    /* STB: push-pull output (chip select, host always drives). */
-    ESP_GOTO_ON_ERROR(_init_gpio(dev_handle->stb_num, GPIO_MODE_OUTPUT,
-                                 dev_config->flags.enable_internal_pullup),
-                      err, TAG, "init STB GPIO failed");
+/** Validate a device configuration (shared by heap and static paths). */
+static esp_err_t _dev_check_config(tm1668_bus_handle_t bus_handle,
+                                   const tm1668_device_config_t *dev_config)
+{
+    ESP_RETURN_ON_FALSE(bus_handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid bus handle");
+    ESP_RETURN_ON_FALSE(dev_config, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device config");
+    ESP_RETURN_ON_FALSE(GPIO_IS_VALID_GPIO(dev_config->stb_io_num),
+                        ESP_ERR_INVALID_ARG, TAG, "invalid STB pin number");
+    return ESP_OK;
+}
+
+esp_err_t tm1668_bus_add_device(tm1668_bus_handle_t bus_handle,
+                                const tm1668_device_config_t *dev_config,
+                                tm1668_dev_handle_t *ret_handle)
+{
+    ESP_RETURN_ON_ERROR(_dev_check_config(bus_handle, dev_config), TAG,
+                        "invalid device config");
+    ESP_RETURN_ON_FALSE(ret_handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle pointer");
+
+    esp_err_t ret = ESP_OK;
+    tm1668_dev_handle_t dev_handle =
+        (tm1668_dev_handle_t)calloc(1, sizeof(struct tm1668_dev_t));
+    ESP_GOTO_ON_FALSE(dev_handle, ESP_ERR_NO_MEM, err, TAG,
+                      "no memory for device");
+    ESP_GOTO_ON_ERROR(_bus_attach(bus_handle, dev_handle, dev_config), err,
+                      TAG, "attach device failed");
 
     *ret_handle = dev_handle;
     return ESP_OK;
 
 err:
-    if (dev_handle) {
-        tm1668_bus_rm_device(dev_handle);
-    }
+    free(dev_handle);
     return ret;
 }
 
+esp_err_t tm1668_bus_add_device_static(tm1668_bus_handle_t bus_handle,
+                                       const tm1668_device_config_t *dev_config,
+                                       tm1668_dev_static_t *dev_buffer,
+                                       tm1668_dev_handle_t *ret_handle)
+{
+    ESP_RETURN_ON_ERROR(_dev_check_config(bus_handle, dev_config), TAG,
+                        "invalid device config");
+    ESP_RETURN_ON_FALSE(dev_buffer, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device buffer");
+    ESP_RETURN_ON_FALSE(ret_handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle pointer");
+
+    tm1668_dev_handle_t dev_handle = (tm1668_dev_handle_t)dev_buffer;
+    memset(dev_handle, 0, sizeof(struct tm1668_dev_t));
+    dev_handle->is_static = true;
+    ESP_RETURN_ON_ERROR(_bus_attach(bus_handle, dev_handle, dev_config), TAG,
+                        "attach device failed");
+
+    *ret_handle = dev_handle;
+    return ESP_OK;
+}
+
 esp_err_t tm1668_bus_rm_device(tm1668_dev_handle_t handle)
 {
     ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
                         "invalid device handle");
 
     tm1668_bus_handle_t tm1668_bus = handle->bus_handle;
-    tm1668_bus_device_list_t *device_item;
     xSemaphoreTake(tm1668_bus->bus_lock_mux, portMAX_DELAY);
-    SLIST_FOREACH(device_item, &tm1668_bus->device_list, next)
-    {
-        if (handle == device_item->device) {
-            SLIST_REMOVE(&tm1668_bus->device_list, device_item,
-                         tm1668_bus_device_list, next);
-            free(device_item);
-            break;
-        }
-    }
+    STAILQ_REMOVE(&tm1668_bus->device_list, handle, tm1668_dev_t, next);
+    tm1668_bus->stb_mask &= ~(1ULL << handle->stb_num);
+    tm1668_bus->pullup_mask &= ~(1ULL << handle->stb_num);
     xSemaphoreGive(tm1668_bus->bus_lock_mux);
-    free(handle);
+    if (!handle->is_static) {
+        free(handle);
+    }
     return ESP_OK;
 }
 
@@ -310,14 +442,20 @@ esp_err_t tm1668_new_device(const tm1668_config_t *config,
     handle->clk_num = config->clk_io_num;
     handle->dio_num = config->dio_io_num;
     handle->stb_num = config->stb_io_num;
+    handle->timing = TIMING_DEFAULT;
+    handle->dio_push_pull = config->flags.dio_push_pull;
+    handle->key_size =
+        config->flags.tm1638 ? TM1638_KEY_SIZE : TM1668_KEY_SIZE;
+    _init_buffer(handle);
 
     /* CLK: push-pull output. */
     ESP_GOTO_ON_ERROR(_init_gpio(handle->clk_num, GPIO_MODE_OUTPUT,
                                  config->flags.enable_internal_pullup),
                       err, TAG, "init CLK GPIO failed");
 
-    /* DIO: open-drain for bidirectional communication. */
-    ESP_GOTO_ON_ERROR(_init_gpio(handle->dio_num, GPIO_MODE_INPUT_OUTPUT_OD,
+    /* DIO: open-drain for bidirectional communication (or push-pull
+     * outside key reads, see _set_dio_od()). */
+    ESP_GOTO_ON_ERROR(_init_gpio(handle->dio_num, _dio_mode(handle),
                                  config->flags.enable_internal_pullup),
                       err, TAG, "init DIO GPIO failed");
 
@@ -343,45 +481,6 @@ esp_err_t tm1668_del_device(tm1668_dev_handle_t handle)
 }
 #endif // CONFIG_TM1668_WITH_BUS
 
-/* Timing: half-clock-cycle delay in microseconds.
- * Datasheet minimum is 1 us; increase for long traces or clone chips. */
-#define DELAY_US CONFIG_TM1668_DELAY_US
-
-/* Settling delay after READ_KEY command before TM1668 drives DIO. */
-#define READ_KEY_DELAY_US CONFIG_TM1668_READ_KEY_DELAY_US
-
-/*
- * Command byte encoding (TM1668 / TM1638 datasheet).
- *
- *   B7 B6 B5 B4 B3 B2 B1 B0
- *   ─────────────────────────
- *   0  0  —  —  —  —  —  —   Display mode setting command
- *   0  1  —  —  —  —  —  —   Data command (0: fixed, 1: auto-increment)
- *   1  0  —  —  —  —  —  —   Display control (on/off + pulse width)
- *   1  1  —  —  —  —  —  —   Address setting (upper 4 bits = 0xC0)
- */
-
-/** Display mode command prefix: 0b00xxxxxx. */
-#define MODE 0x00
-/** Data write mode: auto-increment address after each byte. */
-#define ADDRESS_INCREMENT 0x40
-/** Data write mode: write to fixed address (no auto-increment). */
-#define ADDRESS_FIXED 0x44
-/** Display register address command prefix: 0b11xxxxxx. */
-#define DISPLAY_ADDRESS 0xC0
-/** Mask for the 4-bit address field. */
-#define ADDRESS_MASK 0xF
-/** Read key scan data command. */
-#define READ_KEY 0x42
-/** Mask for the 2-bit mode field. */
-#define MODE_MASK 0x3
-/** Display control command prefix: 0b1000xxxx. */
-#define DISPLAY_CONTROL 0x80
-/** Mask for the 3-bit pulse width field. */
-#define PULSE_WIDTH_MASK 0x7
-/** Bit 3 = display on/off in the display control command. */
-#define DISPLAY_BIT 3
-
 /**
  * @brief Bit-bang one byte to the TM1668 (LSB first, MSB last).
  *
@@ -399,153 +498,985 @@ esp_err_t tm1668_del_device(tm1668_dev_handle_t handle)
 static inline void _send_data(tm1668_bus_handle_t handle, uint8_t value)
 {
     for (int b = 0; b < 8; b++) {
-        gpio_set_level(handle->clk_num, 0);
-        gpio_set_level(handle->dio_num, (value >> b) & 1);
-        esp_rom_delay_us(DELAY_US);
-        gpio_set_level(handle->clk_num, 1);
-        esp_rom_delay_us(DELAY_US);
+        _set_clk(handle, 0);
+        _set_dio(handle, (value >> b) & 1);
+        esp_rom_delay_us(handle->timing.write_delay_us);
+        _set_clk(handle, 1);
+        esp_rom_delay_us(handle->timing.write_delay_us);
     }
-    gpio_set_level(handle->dio_num, 1);
+    _set_dio(handle, 1);
 }
 
 /**
  * @brief Send a command byte to a device (STB-low framing).
  *
- * Enters a critical section to prevent interleaved transactions.
+ * Caller must hold tm1668_lock.
  *
  * @param[in] handle  Device handle.
  * @param[in] command Command byte to send.
  */
-static inline void _send_command(tm1668_dev_handle_t handle, uint8_t command)
+static inline void _command_frame(tm1668_dev_handle_t handle, uint8_t command)
 {
-    portENTER_CRITICAL(&g_lock);
-    gpio_set_level(handle->stb_num, 0);
+    TM1668_TP_COMMAND(handle->stb_num, command);
+    _set_stb(handle, 0);
     _send_data(BUS_HANDLE(handle), command);
-    gpio_set_level(handle->stb_num, 1);
-    portEXIT_CRITICAL(&g_lock);
+    _set_stb(handle, 1);
 }
 
-esp_err_t tm1668_reset(tm1668_dev_handle_t handle)
+/** Timer-engine counterpart of _command_frame(). Caller owns the engine. */
+static inline void _engine_command(tm1668_dev_handle_t handle, uint8_t command)
 {
-    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
-                        "invalid device handle");
-
-    _send_command(handle, ADDRESS_INCREMENT);
-    handle->address_fixed = false;
-
-    return ESP_OK;
+    TM1668_TP_COMMAND(handle->stb_num, command);
+    tm1668_engine_frame(BUS_HANDLE(handle), 1ULL << handle->stb_num, &command,
+                        1, NULL, 0);
 }
 
-esp_err_t tm1668_display_auto(tm1668_dev_handle_t handle, uint8_t address,
-                              const uint8_t *data, size_t size)
+/**
+ * @brief Send a command byte to a device (STB-low framing).
+ *
+ * Takes tm1668_lock as an urgent transaction.
+ *
+ * @param[in] handle  Device handle.
+ * @param[in] command Command byte to send.
+ */
+static inline void _send_command(tm1668_dev_handle_t handle, uint8_t command)
 {
-    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
-                        "invalid device handle");
-    ESP_RETURN_ON_FALSE(address < 0x10, ESP_ERR_INVALID_ARG, TAG,
-                        "invalid address");
-    ESP_RETURN_ON_FALSE(address + size <= 0x10, ESP_ERR_INVALID_ARG, TAG,
-                        "invalid size");
+    if (tm1668_engine_begin(BUS_HANDLE(handle))) {
+        _engine_command(handle, command);
+        tm1668_engine_unlock();
+        return;
+    }
+    _urgent_enter();
+    _command_frame(handle, command);
+    _urgent_exit();
+}
 
-    /* Switch to auto-increment mode if needed (cached). */
+/**
+ * @brief Write display bytes in one auto-increment transaction.
+ *
+ * Switches the device to auto-increment mode first if needed (cached).
+ * Caller must hold tm1668_lock.
+ *
+ * @param[in] handle  Device handle.
+ * @param[in] address Starting display register address.
+ * @param[in] data    Bytes to write.
+ * @param[in] size    Number of bytes.
+ */
+static inline void _display_frame(tm1668_dev_handle_t handle, uint8_t address,
+                                  const uint8_t *data, size_t size)
+{
     if (handle->address_fixed) {
-        _send_command(handle, ADDRESS_INCREMENT);
+        _command_frame(handle, ADDRESS_INCREMENT);
         handle->address_fixed = false;
     }
 
     /* One continuous transaction: STB low → address + data bytes → STB high. */
-    portENTER_CRITICAL(&g_lock);
-    gpio_set_level(handle->stb_num, 0);
-    _send_data(BUS_HANDLE(handle), DISPLAY_ADDRESS | (ADDRESS_MASK & address));
+    TM1668_TP_DISPLAY_BEGIN(handle->stb_num, address, size);
+    _set_stb(handle, 0);
+    _send_data(BUS_HANDLE(handle), ADDRESS_COMMAND(address));
     for (int n = 0; n < size; n++) {
         _send_data(BUS_HANDLE(handle), data[n]);
     }
-    gpio_set_level(handle->stb_num, 1);
-    portEXIT_CRITICAL(&g_lock);
+    _set_stb(handle, 1);
+    TM1668_TP_DISPLAY_END(handle->stb_num);
+}
 
-    return ESP_OK;
+/**
+ * @brief Timer-engine counterpart of _display_frame().
+ *
+ * Switches the device to the requested address mode if needed, then sends
+ * the address and data bytes in one frame. Caller owns the engine.
+ *
+ * @param[in] handle  Device handle.
+ * @param[in] fixed   Use fixed-address mode (size must be 1).
+ * @param[in] address Starting display register address.
+ * @param[in] data    Bytes to write.
+ * @param[in] size    Number of bytes.
+ */
+static void _engine_display(tm1668_dev_handle_t handle, bool fixed,
+                            uint8_t address, const uint8_t *data, size_t size)
+{
+    uint8_t tx[1 + DISPLAY_RAM_SIZE];
+    if (handle->address_fixed != fixed) {
+        _engine_command(handle, DATA_COMMAND(fixed));
+        handle->address_fixed = fixed;
+    }
+    tx[0] = ADDRESS_COMMAND(address);
+    memcpy(&tx[1], data, size);
+    TM1668_TP_DISPLAY_BEGIN(handle->stb_num, address, size);
+    tm1668_engine_frame(BUS_HANDLE(handle), 1ULL << handle->stb_num, tx,
+                        1 + size, NULL, 0);
+    TM1668_TP_DISPLAY_END(handle->stb_num);
 }
 
-esp_err_t tm1668_display_fixed(tm1668_dev_handle_t handle, uint8_t address,
-                               uint8_t data)
+/** Timer-engine counterpart of _read_key_frame(). Caller owns the engine. */
+static void _engine_read_key(tm1668_dev_handle_t handle, uint8_t *data,
+                             size_t size)
 {
-    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
-                        "invalid device handle");
-    ESP_RETURN_ON_FALSE(address < 0x10, ESP_ERR_INVALID_ARG, TAG,
-                        "invalid address");
+    const uint8_t command = READ_KEY;
+    TM1668_TP_KEY_BEGIN(handle->stb_num, size);
+    tm1668_engine_frame(BUS_HANDLE(handle), 1ULL << handle->stb_num,
+                        &command, 1, data, size);
+    TM1668_TP_KEY_END(handle->stb_num, data, size);
+}
 
-    /* Switch to fixed-address mode if needed (cached). */
-    if (!handle->address_fixed) {
-        _send_command(handle, ADDRESS_FIXED);
-        handle->address_fixed = true;
+/**
+ * @brief Write display bytes as a bulk transfer that urgent transactions
+ *        may interrupt.
+ *
+ * Sends one auto-increment burst when the bus is uncontended. If an urgent
+ * transaction (key scan, command, short write) is queued, the burst is
+ * ended at the current byte boundary, the lock is released until the
+ * urgent transactions are done, and a new burst resumes at the next
+ * address. A key scan thus waits for at most one byte of a long flush.
+ * Caller must NOT hold tm1668_lock.
+ *
+ * @param[in] handle  Device handle.
+ * @param[in] address Starting display register address.
+ * @param[in] data    Bytes to write.
+ * @param[in] size    Number of bytes.
+ */
+static void _display_bulk(tm1668_dev_handle_t handle, uint8_t address,
+                          const uint8_t *data, size_t size)
+{
+    /* Slow bus: the task sleeps during the frame, nothing to split. */
+    if (tm1668_engine_begin(BUS_HANDLE(handle))) {
+        _engine_display(handle, false, address, data, size);
+        tm1668_engine_unlock();
+        return;
     }
 
-    portENTER_CRITICAL(&g_lock);
-    gpio_set_level(handle->stb_num, 0);
-    _send_data(BUS_HANDLE(handle), DISPLAY_ADDRESS | (ADDRESS_MASK & address));
-    _send_data(BUS_HANDLE(handle), data);
-    gpio_set_level(handle->stb_num, 1);
-    portEXIT_CRITICAL(&g_lock);
-
-    return ESP_OK;
+    bool yield = true;
+    size_t n = 0;
+    portENTER_CRITICAL(&tm1668_lock);
+    for (;;) {
+        /* An urgent fixed-address write may have run in between. */
+        if (handle->address_fixed) {
+            _command_frame(handle, ADDRESS_INCREMENT);
+            handle->address_fixed = false;
+        }
+        TM1668_TP_DISPLAY_BEGIN(handle->stb_num, address + n, size - n);
+        _set_stb(handle, 0);
+        _send_data(BUS_HANDLE(handle),
+                   ADDRESS_COMMAND(address + n));
+        do {
+            _send_data(BUS_HANDLE(handle), data[n++]);
+        } while (n < size && !(yield && tm1668_urgent));
+        _set_stb(handle, 1);
+        TM1668_TP_DISPLAY_END(handle->stb_num);
+        if (n == size) {
+            break;
+        }
+        portEXIT_CRITICAL(&tm1668_lock);
+        /* Give up splitting for this transfer if the waiter never came. */
+        yield = _yield_to_urgent();
+        portENTER_CRITICAL(&tm1668_lock);
+    }
+    portEXIT_CRITICAL(&tm1668_lock);
 }
 
-esp_err_t tm1668_read_key(tm1668_dev_handle_t handle, uint8_t *data,
-                          size_t size)
+/**
+ * @brief Read key scan bytes in one transaction.
+ *
+ * Caller must hold tm1668_lock.
+ *
+ * @param[in]  handle Device handle.
+ * @param[out] data   Buffer to receive key data.
+ * @param[in]  size   Number of bytes to read.
+ */
+static inline void _read_key_frame(tm1668_dev_handle_t handle, uint8_t *data,
+                                   size_t size)
 {
-    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
-                        "invalid device handle");
-    ESP_RETURN_ON_FALSE(data, ESP_ERR_INVALID_ARG, TAG, "invalid data pointer");
-    ESP_RETURN_ON_FALSE(size <= 0x10, ESP_ERR_INVALID_ARG, TAG, "invalid size");
-
     /* Key scan read sequence:
      * 1. STB low → send READ_KEY command (host drives DIO).
-     * 2. Release DIO, wait READ_KEY_DELAY_US for TM1668 to start driving.
+     * 2. Release DIO (open-drain from here on), wait read_key_delay_us for
+     *    TM1668 to start driving.
      * 3. Clock in `size` bytes LSB-first.
      * 4. STB high. */
-    portENTER_CRITICAL(&g_lock);
-    gpio_set_level(handle->stb_num, 0);
+    const tm1668_timing_t *timing = &BUS_HANDLE(handle)->timing;
+    TM1668_TP_KEY_BEGIN(handle->stb_num, size);
+    _set_stb(handle, 0);
     _send_data(BUS_HANDLE(handle), READ_KEY);
-    gpio_set_level(BUS_HANDLE(handle)->dio_num, 1);
-    esp_rom_delay_us(READ_KEY_DELAY_US);
+    _set_dio_od(BUS_HANDLE(handle), true);
+    _set_dio(BUS_HANDLE(handle), 1);
+    esp_rom_delay_us(timing->read_key_delay_us);
     for (int n = 0; n < size; n++) {
         data[n] = 0;
         for (int b = 0; b < 8; b++) {
-            gpio_set_level(BUS_HANDLE(handle)->clk_num, 0);
-            esp_rom_delay_us(DELAY_US);
-            gpio_set_level(BUS_HANDLE(handle)->clk_num, 1);
-            esp_rom_delay_us(DELAY_US);
-            data[n] |= gpio_get_level(BUS_HANDLE(handle)->dio_num) << b;
+            _set_clk(BUS_HANDLE(handle), 0);
+            esp_rom_delay_us(timing->read_delay_us);
+            _set_clk(BUS_HANDLE(handle), 1);
+            esp_rom_delay_us(timing->read_delay_us);
+            data[n] |= _get_dio(BUS_HANDLE(handle)) << b;
         }
     }
-    gpio_set_level(BUS_HANDLE(handle)->dio_num, 1);
-    gpio_set_level(handle->stb_num, 1);
-    portEXIT_CRITICAL(&g_lock);
-
-    return ESP_OK;
+    _set_dio(BUS_HANDLE(handle), 1);
+    _set_stb(handle, 1);
+    /* The chip has let go of DIO once STB is high. */
+    _set_dio_od(BUS_HANDLE(handle), false);
+    TM1668_TP_KEY_END(handle->stb_num, data, size);
 }
 
-esp_err_t tm1668_set_mode(tm1668_dev_handle_t handle, uint8_t value)
+/**
+ * @brief Record the display mode after a mode command.
+ *
+ * Addresses that become driven are marked dirty, since writes to them were
+ * skipped while they were unused.
+ */
+static void _record_mode(tm1668_dev_handle_t handle, uint8_t mode)
 {
-    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
-                        "invalid device handle");
-
-    /* Display mode command: 0b00MMxxxx.
-     * Only valid on TM1668 (TM1638 ignores this command). */
-    _send_command(handle, MODE | (MODE_MASK & value));
-
-    return ESP_OK;
+    uint16_t used = MODE_USED(mode & MODE_MASK);
+    portENTER_CRITICAL(&handle->buf_lock);
+    handle->dirty |= used & ~handle->used;
+    handle->used = used;
+    handle->seg_hi = MODE_SEG_HI(mode & MODE_MASK);
+    portEXIT_CRITICAL(&handle->buf_lock);
 }
 
-esp_err_t tm1668_set_pulse(tm1668_dev_handle_t handle, uint8_t value)
+void tm1668_command_unchecked(tm1668_dev_handle_t handle, uint8_t command)
+{
+    bool engine = tm1668_engine_begin(BUS_HANDLE(handle));
+    if (engine) {
+        _engine_command(handle, command);
+    } else {
+        _urgent_enter();
+        _command_frame(handle, command);
+    }
+    /* Mirror the command into the cached state while the bus is still
+     * held, so no other transfer sees the old mode. */
+    switch (command & COMMAND_GROUP_MASK) {
+    case MODE:
+        _record_mode(handle, command);
+        break;
+    case ADDRESS_INCREMENT & COMMAND_GROUP_MASK:
+        handle->address_fixed = (command & ADDRESS_FIXED_BIT) != 0;
+        break;
+    case DISPLAY_CONTROL:
+        handle->display_on = (command >> DISPLAY_BIT) & 1;
+        handle->pulse_width = command & PULSE_WIDTH_MASK;
+        break;
+    default:
+        break;
+    }
+    if (engine) {
+        tm1668_engine_unlock();
+    } else {
+        _urgent_exit();
+    }
+}
+
+/**
+ * @brief Take a snapshot of the pending (dirty) display bytes.
+ *
+ * Copies the shadow buffer and marks it clean, so that staging from other
+ * tasks can continue while the snapshot is being sent.
+ *
+ * With a board remap attached, the snapshot and the returned bitmask are
+ * in chip order.
+ *
+ * @param[in]  handle Device handle.
+ * @param[out] buf    Receives the shadow (DISPLAY_RAM_SIZE bytes).
+ * @param[in]  mask   Addresses to take; others stay pending.
+ * @return Bitmask of the pending addresses, 0 if nothing is pending.
+ */
+static uint16_t _take_dirty(tm1668_dev_handle_t handle, uint8_t *buf,
+                            uint16_t mask)
+{
+    uint8_t logical[DISPLAY_RAM_SIZE];
+    portENTER_CRITICAL(&handle->buf_lock);
+    const tm1668_remap_t *remap = handle->remap;
+    uint16_t dirty = handle->dirty & mask;
+    if (dirty) {
+        memcpy(remap ? logical : buf, handle->display, DISPLAY_RAM_SIZE);
+        handle->dirty &= ~dirty;
+    }
+    portEXIT_CRITICAL(&handle->buf_lock);
+    /* Remapping moves whole grids, so the whole grid pair is resent. */
+    if (dirty && remap) {
+        tm1668_remap_frame(remap, logical, buf);
+        dirty = _remap_dirty(remap, dirty);
+    }
+    return dirty;
+}
+
+/**
+ * @brief Send a snapshot as the fewest auto-increment bursts.
+ *
+ * Dirty runs separated by a single clean byte are merged: resending that
+ * byte costs the same 8 clocks as the address byte of a new burst and saves
+ * the extra STB frame. Wider gaps start a new burst. Addresses unused in
+ * the current display mode are never sent. Each burst is a bulk transfer,
+ * see _display_bulk(). Caller must NOT hold tm1668_lock.
+ *
+ * @param[in] handle Device handle.
+ * @param[in] buf    Shadow snapshot from _take_dirty().
+ * @param[in] dirty  Bitmask of the addresses to send.
+ */
+static void _display_runs(tm1668_dev_handle_t handle, const uint8_t *buf,
+                          uint16_t dirty)
+{
+    uint32_t rest = dirty & handle->used;
+    while (rest) {
+        uint8_t first;
+        size_t size = _next_run(&rest, &first);
+        _display_bulk(handle, first, &buf[first], size);
+        LATENCY_SENT(handle);
+    }
+}
+
+/**
+ * @brief Immediate write on a remapped device: store and flush.
+ *
+ * The chip addresses of logical bytes are only known grid by grid, so the
+ * bytes are marked dirty and sent with the shadow through _take_dirty().
+ */
+static void _remap_write(tm1668_dev_handle_t handle, uint8_t address,
+                         const uint8_t *data, size_t size)
+{
+    uint8_t buf[DISPLAY_RAM_SIZE];
+    portENTER_CRITICAL(&handle->buf_lock);
+    memcpy(&handle->display[address], data, size);
+    handle->dirty |= ADDRESS_RANGE(address, size);
+    portEXIT_CRITICAL(&handle->buf_lock);
+    _display_runs(handle, buf, _take_dirty(handle, buf, 0xFFFF));
+}
+
+/** Store display bytes in the shadow buffer; mark changed bytes dirty. */
+static void _stage(tm1668_dev_handle_t handle, uint8_t address,
+                   const uint8_t *data, size_t size)
+{
+    portENTER_CRITICAL(&handle->buf_lock);
+    for (int n = 0; n < size; n++) {
+        if (handle->display[address + n] != data[n]) {
+            handle->display[address + n] = data[n];
+            handle->dirty |= 1U << (address + n);
+        }
+    }
+    portEXIT_CRITICAL(&handle->buf_lock);
+}
+
+esp_err_t tm1668_reset(tm1668_dev_handle_t handle)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+
+    _send_command(handle, ADDRESS_INCREMENT);
+    handle->address_fixed = false;
+
+    return ESP_OK;
+}
+
+void tm1668_display_auto_unchecked(tm1668_dev_handle_t handle, uint8_t address,
+                                   const uint8_t *data, size_t size)
+{
+    if (handle->remap) {
+        _remap_write(handle, address, data, size);
+        return;
+    }
+    _store(handle, address, data, size);
+    /* The driven addresses of every mode start at 0, so clipping the tail
+     * is all it takes to skip the unused ones. */
+    size_t used_end = 32 - __builtin_clz(handle->used);
+    if (address + size > used_end) {
+        size = address < used_end ? used_end - address : 0;
+    }
+    if (size > URGENT_WRITE_MAX) {
+        _display_bulk(handle, address, data, size);
+        LATENCY_SENT(handle);
+    } else if (size) {
+        if (tm1668_engine_begin(BUS_HANDLE(handle))) {
+            _engine_display(handle, false, address, data, size);
+            tm1668_engine_unlock();
+        } else {
+            _urgent_enter();
+            _display_frame(handle, address, data, size);
+            _urgent_exit();
+        }
+        LATENCY_SENT(handle);
+    }
+}
+
+esp_err_t tm1668_display_auto(tm1668_dev_handle_t handle, uint8_t address,
+                              const uint8_t *data, size_t size)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+    ESP_RETURN_ON_FALSE(address < 0x10, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid address");
+    ESP_RETURN_ON_FALSE(address + size <= 0x10, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid size");
+
+    tm1668_display_auto_unchecked(handle, address, data, size);
+
+    return ESP_OK;
+}
+
+void tm1668_display_fixed_unchecked(tm1668_dev_handle_t handle,
+                                    uint8_t address, uint8_t data)
+{
+    if (handle->remap) {
+        _remap_write(handle, address, &data, 1);
+        return;
+    }
+    _store(handle, address, &data, 1);
+    if (!(handle->used & (1U << address))) {
+        return;
+    }
+    if (tm1668_engine_begin(BUS_HANDLE(handle))) {
+        _engine_display(handle, true, address, &data, 1);
+        tm1668_engine_unlock();
+        LATENCY_SENT(handle);
+        return;
+    }
+    _urgent_enter();
+    /* Switch to fixed-address mode if needed (cached). */
+    if (!handle->address_fixed) {
+        _command_frame(handle, ADDRESS_FIXED);
+        handle->address_fixed = true;
+    }
+    TM1668_TP_DISPLAY_BEGIN(handle->stb_num, address, 1);
+    _set_stb(handle, 0);
+    _send_data(BUS_HANDLE(handle), ADDRESS_COMMAND(address));
+    _send_data(BUS_HANDLE(handle), data);
+    _set_stb(handle, 1);
+    TM1668_TP_DISPLAY_END(handle->stb_num);
+    _urgent_exit();
+    LATENCY_SENT(handle);
+}
+
+esp_err_t tm1668_display_fixed(tm1668_dev_handle_t handle, uint8_t address,
+                               uint8_t data)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+    ESP_RETURN_ON_FALSE(address < 0x10, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid address");
+
+    tm1668_display_fixed_unchecked(handle, address, data);
+
+    return ESP_OK;
+}
+
+esp_err_t tm1668_display_buffer(tm1668_dev_handle_t handle, uint8_t address,
+                                const uint8_t *data, size_t size)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+    ESP_RETURN_ON_FALSE(data, ESP_ERR_INVALID_ARG, TAG, "invalid data pointer");
+    ESP_RETURN_ON_FALSE(address < 0x10, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid address");
+    ESP_RETURN_ON_FALSE(address + size <= 0x10, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid size");
+
+    _stage(handle, address, data, size);
+
+    return ESP_OK;
+}
+
+esp_err_t tm1668_set_segment(tm1668_dev_handle_t handle, uint8_t grid,
+                             uint8_t seg, bool on)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+    ESP_RETURN_ON_FALSE(grid < DISPLAY_RAM_SIZE / 2 && seg < 16,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid grid/segment");
+
+    /* GRIDn owns addresses 2n (SEG1–8) and 2n+1 (SEG9–16), LSB first. */
+    uint8_t address = grid * 2 + (seg >> 3);
+    uint8_t mask = 1U << (seg & 7);
+    /* The mode decides about the chip line the segment is wired to. */
+    uint8_t chip_grid = grid, chip_seg = seg;
+    const tm1668_remap_t *remap = handle->remap;
+    if (remap) {
+        chip_grid = remap->grid[grid];
+        chip_seg = __builtin_ctz(seg < 8 ? remap->lo[mask] : remap->hi[mask]);
+    }
+    ESP_RETURN_ON_FALSE((handle->used & (1U << (chip_grid * 2))) &&
+                            (chip_seg < 8 ||
+                             (handle->seg_hi & (1U << (chip_seg & 7)))),
+                        ESP_ERR_INVALID_ARG, TAG,
+                        "segment not driven in this mode");
+    portENTER_CRITICAL(&handle->buf_lock);
+    uint8_t value = on ? handle->display[address] | mask
+                       : handle->display[address] & ~mask;
+    if (value != handle->display[address]) {
+        handle->display[address] = value;
+        handle->dirty |= 1U << address;
+    }
+    portEXIT_CRITICAL(&handle->buf_lock);
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Send the whole cached chip state (see tm1668_resync()).
+ *
+ * A reset chip powers up with the display off, in auto-increment mode and
+ * in its default display mode, with undefined display RAM. The commands
+ * are sent in datasheet order: mode, data command, display data (one burst
+ * over every driven address), display control.
+ */
+static void _resync(tm1668_dev_handle_t handle)
+{
+    portENTER_CRITICAL(&handle->buf_lock);
+    handle->resync = false;
+    handle->dirty = 0xFFFF;
+    uint16_t used = handle->used;
+    portEXIT_CRITICAL(&handle->buf_lock);
+
+    if (used != 0xFFFF) {
+        tm1668_command_unchecked(handle, MODE_COMMAND(USED_MODE(used)));
+    }
+    tm1668_command_unchecked(handle, ADDRESS_INCREMENT);
+    uint8_t buf[DISPLAY_RAM_SIZE];
+    _display_runs(handle, buf, _take_dirty(handle, buf, 0xFFFF));
+    tm1668_command_unchecked(handle,
+                             DISPLAY_CONTROL_COMMAND(handle->display_on,
+                                                     handle->pulse_width));
+}
+
+/** Take the resync request of a device, if any. */
+static bool _take_resync(tm1668_dev_handle_t handle)
+{
+    portENTER_CRITICAL(&handle->buf_lock);
+    bool resync = handle->resync;
+    handle->resync = false;
+    portEXIT_CRITICAL(&handle->buf_lock);
+    return resync;
+}
+
+esp_err_t tm1668_flush(tm1668_dev_handle_t handle)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+
+    if (_take_resync(handle)) {
+        _resync(handle);
+        return ESP_OK;
+    }
+    uint8_t buf[DISPLAY_RAM_SIZE];
+    uint16_t dirty = _take_dirty(handle, buf, 0xFFFF);
+    _display_runs(handle, buf, dirty);
+
+    return ESP_OK;
+}
+
+esp_err_t tm1668_resync(tm1668_dev_handle_t handle)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+
+    _resync(handle);
+
+    return ESP_OK;
+}
+
+void tm1668_request_resync(tm1668_dev_handle_t handle)
+{
+    portENTER_CRITICAL_SAFE(&handle->buf_lock);
+    handle->resync = true;
+    portEXIT_CRITICAL_SAFE(&handle->buf_lock);
+}
+
+/** Logical addresses of the grids touched by the chip addresses in dirty. */
+static uint16_t _unmap_dirty(const tm1668_remap_t *remap, uint16_t dirty)
+{
+    uint16_t out = 0;
+    for (int g = 0; g < TM1668_REMAP_GRIDS; g++) {
+        if (dirty & (3U << (2 * remap->grid[g]))) {
+            out |= 3U << (2 * g);
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Send the pending bytes that fit into a time budget.
+ *
+ * Bursts go out in address order, as in _display_runs(), while their
+ * estimated time fits; the first one that does not is cut at the last byte
+ * that does, and what is left is marked pending again.
+ *
+ * @param[in] handle    Device handle.
+ * @param[in] mask      Logical addresses to consider.
+ * @param[in] budget_us Time budget in microseconds.
+ * @return Addresses in mask still pending.
+ */
+static uint16_t _flush_budget(tm1668_dev_handle_t handle, uint16_t mask,
+                              uint32_t budget_us)
+{
+    uint8_t buf[DISPLAY_RAM_SIZE];
+    uint32_t rest = _take_dirty(handle, buf, mask) & handle->used;
+    while (rest) {
+        uint32_t unsent = rest;
+        uint8_t first;
+        size_t size = _next_run(&rest, &first);
+        tm1668_cost_t mode = {0};
+        if (handle->address_fixed) {
+            tm1668_cost_frame(BUS_HANDLE(handle), 1, 0, &mode);
+        }
+        size_t n = size;
+        for (; n; n--) {
+            tm1668_cost_t cost = mode;
+            tm1668_cost_frame(BUS_HANDLE(handle), 1 + n, 0, &cost);
+            if (cost.us <= budget_us) {
+                budget_us -= cost.us;
+                break;
+            }
+        }
+        if (n) {
+            _display_bulk(handle, first, &buf[first], n);
+            LATENCY_SENT(handle);
+        }
+        if (n < size) {
+            rest = unsent & ~ADDRESS_RANGE(first, n);
+            break;
+        }
+    }
+
+    const tm1668_remap_t *remap = handle->remap;
+    uint16_t pending = remap ? _unmap_dirty(remap, rest) : rest;
+    portENTER_CRITICAL(&handle->buf_lock);
+    handle->dirty |= pending;
+    pending = handle->dirty & mask;
+    portEXIT_CRITICAL(&handle->buf_lock);
+    return pending;
+}
+
+esp_err_t tm1668_flush_budget(tm1668_dev_handle_t handle, uint32_t budget_us,
+                              uint16_t *ret_pending)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+
+    uint16_t pending;
+    portENTER_CRITICAL(&handle->buf_lock);
+    bool resync = handle->resync;
+    portEXIT_CRITICAL(&handle->buf_lock);
+    if (resync) {
+        /* Half a resync would leave the chip in a mode nobody asked for. */
+        tm1668_cost_t cost;
+        tm1668_estimate_cost(handle, TM1668_COST_FLUSH, 0, 0, &cost);
+        pending = 0xFFFF;
+        if (cost.us <= budget_us && _take_resync(handle)) {
+            _resync(handle);
+            pending = 0;
+        }
+    } else {
+        pending = _flush_budget(handle, 0xFFFF, budget_us);
+    }
+    if (ret_pending) {
+        *ret_pending = pending;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t tm1668_display_budget(tm1668_dev_handle_t handle, uint8_t address,
+                                const uint8_t *data, size_t size,
+                                uint32_t budget_us, uint16_t *ret_pending)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+    ESP_RETURN_ON_FALSE(data, ESP_ERR_INVALID_ARG, TAG, "invalid data pointer");
+    ESP_RETURN_ON_FALSE(address < 0x10, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid address");
+    ESP_RETURN_ON_FALSE(address + size <= 0x10, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid size");
+
+    /* Sent like tm1668_display_auto(): every byte, changed or not. */
+    uint16_t range = ADDRESS_RANGE(address, size);
+    portENTER_CRITICAL(&handle->buf_lock);
+    memcpy(&handle->display[address], data, size);
+    handle->dirty |= range;
+    portEXIT_CRITICAL(&handle->buf_lock);
+    uint16_t pending = _flush_budget(handle, range, budget_us);
+    if (ret_pending) {
+        *ret_pending = pending;
+    }
+
+    return ESP_OK;
+}
+
+/** Send the display bytes changed by reflex bindings during a key scan. */
+static void _send_reflex(tm1668_dev_handle_t handle, uint16_t changed)
+{
+    if (changed) {
+        uint8_t buf[DISPLAY_RAM_SIZE];
+        _display_runs(handle, buf, _take_dirty(handle, buf, changed));
+    }
+}
+
+void tm1668_read_key_unchecked(tm1668_dev_handle_t handle, uint8_t *data,
+                               size_t size)
+{
+    if (tm1668_engine_begin(BUS_HANDLE(handle))) {
+        _engine_read_key(handle, data, size);
+        tm1668_engine_unlock();
+    } else {
+        _urgent_enter();
+        _read_key_frame(handle, data, size);
+        _urgent_exit();
+    }
+    _send_reflex(handle, _store_key(handle, data, size));
+}
+
+esp_err_t tm1668_read_key(tm1668_dev_handle_t handle, uint8_t *data,
+                          size_t size)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+    ESP_RETURN_ON_FALSE(data, ESP_ERR_INVALID_ARG, TAG, "invalid data pointer");
+    ESP_RETURN_ON_FALSE(size <= 0x10, ESP_ERR_INVALID_ARG, TAG, "invalid size");
+
+    tm1668_read_key_unchecked(handle, data, size);
+
+    return ESP_OK;
+}
+
+esp_err_t tm1668_get_key(tm1668_dev_handle_t handle, uint8_t *data,
+                         size_t size)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+    ESP_RETURN_ON_FALSE(data, ESP_ERR_INVALID_ARG, TAG, "invalid data pointer");
+    ESP_RETURN_ON_FALSE(size <= TM1668_KEY_SIZE, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid size");
+
+    portENTER_CRITICAL(&handle->buf_lock);
+    memcpy(data, handle->key, size);
+    portEXIT_CRITICAL(&handle->buf_lock);
+
+    return ESP_OK;
+}
+
+/** Unpack debounced key bits into key bytes. */
+static void _unpack_keys(uint64_t bits, uint8_t *data, size_t size)
+{
+    for (int n = 0; n < size; n++) {
+        data[n] = bits >> (8 * n);
+    }
+}
+
+/** Copy debounced keys and take the edges; caller holds buf_lock. */
+static void _take_keys(tm1668_dev_handle_t handle, uint8_t *state,
+                       uint8_t *pressed, uint8_t *released, size_t size)
+{
+    struct tm1668_debounce_t *db = &handle->debounce;
+    if (state) {
+        _unpack_keys(db->state, state, size);
+    }
+    if (pressed) {
+        _unpack_keys(db->pressed, pressed, size);
+        db->pressed = 0;
+    }
+    if (released) {
+        _unpack_keys(db->released, released, size);
+        db->released = 0;
+    }
+}
+
+esp_err_t tm1668_get_keys(tm1668_dev_handle_t handle, uint8_t *state,
+                          uint8_t *pressed, uint8_t *released, size_t size)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+    ESP_RETURN_ON_FALSE(size <= TM1668_KEY_SIZE, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid size");
+
+    portENTER_CRITICAL(&handle->buf_lock);
+    _take_keys(handle, state, pressed, released, size);
+    portEXIT_CRITICAL(&handle->buf_lock);
+
+    return ESP_OK;
+}
+
+#ifdef CONFIG_TM1668_WITH_BUS
+esp_err_t tm1668_bus_get_keys(tm1668_bus_handle_t bus_handle, uint8_t *state,
+                              uint8_t *pressed, uint8_t *released,
+                              size_t size)
+{
+    ESP_RETURN_ON_FALSE(bus_handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid bus handle");
+
+    esp_err_t ret = ESP_OK;
+    size_t offset = 0;
+    tm1668_dev_handle_t item;
+    xSemaphoreTake(bus_handle->bus_lock_mux, portMAX_DELAY);
+    STAILQ_FOREACH(item, &bus_handle->device_list, next)
+    {
+        if (offset + TM1668_KEY_SIZE > size) {
+            ret = ESP_ERR_INVALID_SIZE;
+            break;
+        }
+        portENTER_CRITICAL(&item->buf_lock);
+        _take_keys(item, state ? state + offset : NULL,
+                   pressed ? pressed + offset : NULL,
+                   released ? released + offset : NULL, TM1668_KEY_SIZE);
+        portEXIT_CRITICAL(&item->buf_lock);
+        offset += TM1668_KEY_SIZE;
+    }
+    xSemaphoreGive(bus_handle->bus_lock_mux);
+
+    return ret;
+}
+
+esp_err_t tm1668_bus_tick(tm1668_bus_handle_t bus_handle)
+{
+    ESP_RETURN_ON_FALSE(bus_handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid bus handle");
+
+    /* The bus semaphore is held for the whole pass so that the device list
+     * (and therefore the visiting order) cannot change underneath us.
+     * For each device, pending display bytes go out as bulk transfers that
+     * urgent requests from other tasks may interrupt, then the key scan. */
+    uint8_t buf[DISPLAY_RAM_SIZE];
+    uint8_t key[TM1668_KEY_SIZE];
+    tm1668_dev_handle_t item;
+    xSemaphoreTake(bus_handle->bus_lock_mux, portMAX_DELAY);
+    STAILQ_FOREACH(item, &bus_handle->device_list, next)
+    {
+        if (_take_resync(item)) {
+            _resync(item);
+        } else {
+            uint16_t dirty = _take_dirty(item, buf, 0xFFFF);
+            _display_runs(item, buf, dirty);
+        }
+        if (tm1668_engine_begin(bus_handle)) {
+            _engine_read_key(item, key, item->key_size);
+            tm1668_engine_unlock();
+        } else {
+            _urgent_enter();
+            _read_key_frame(item, key, item->key_size);
+            _urgent_exit();
+        }
+        _send_reflex(item, _store_key(item, key, item->key_size));
+    }
+    xSemaphoreGive(bus_handle->bus_lock_mux);
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Send one frame to every device on the bus at once.
+ *
+ * All STB lines go low together, so each chip receives the same command
+ * and data bytes. Only DIO writes are involved: nothing is read back.
+ */
+static void _broadcast_frame(tm1668_bus_handle_t bus_handle, uint8_t command,
+                             const uint8_t *data, size_t size)
+{
+    if (tm1668_engine_begin(bus_handle)) {
+        uint8_t tx[1 + DISPLAY_RAM_SIZE];
+        tx[0] = command;
+        if (size) {
+            memcpy(&tx[1], data, size);
+        }
+        tm1668_engine_frame(bus_handle, bus_handle->stb_mask, tx, 1 + size,
+                            NULL, 0);
+        tm1668_engine_unlock();
+        return;
+    }
+    /* Hold the engine while bit-banging too: a timing change in between
+     * could otherwise start engine frames on this bus. */
+    tm1668_engine_lock();
+    portENTER_CRITICAL(&tm1668_lock);
+    _set_stb_mask(bus_handle->stb_mask, 0);
+    esp_rom_delay_us(bus_handle->timing.stb_setup_us);
+    _send_data(bus_handle, command);
+    for (int n = 0; n < size; n++) {
+        _send_data(bus_handle, data[n]);
+    }
+    esp_rom_delay_us(bus_handle->timing.stb_hold_us);
+    _set_stb_mask(bus_handle->stb_mask, 1);
+    portEXIT_CRITICAL(&tm1668_lock);
+    tm1668_engine_unlock();
+}
+
+esp_err_t tm1668_bus_init_all(tm1668_bus_handle_t bus_handle,
+                              const tm1668_bus_init_config_t *init_config)
+{
+    ESP_RETURN_ON_FALSE(bus_handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid bus handle");
+    ESP_RETURN_ON_FALSE(init_config, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid init config");
+
+    static const uint8_t blank[DISPLAY_RAM_SIZE];
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(bus_handle->bus_lock_mux, portMAX_DELAY);
+
+    /* One gpio_config() per pin mode and pull-up setting, whatever the
+     * number of devices. */
+    const uint64_t out_mask =
+        bus_handle->stb_mask | (1ULL << bus_handle->clk_num);
+    const uint64_t dio = 1ULL << bus_handle->dio_num;
+    const uint64_t pullup = bus_handle->pullup_mask;
+    ESP_GOTO_ON_ERROR(_init_gpio_mask(out_mask & pullup, GPIO_MODE_OUTPUT, true),
+                      out, TAG, "init CLK/STB GPIOs failed");
+    ESP_GOTO_ON_ERROR(
+        _init_gpio_mask(out_mask & ~pullup, GPIO_MODE_OUTPUT, false), out, TAG,
+        "init CLK/STB GPIOs failed");
+    ESP_GOTO_ON_ERROR(_init_gpio_mask(dio, _dio_mode(bus_handle),
+                                      pullup & dio),
+                      out, TAG, "init DIO GPIO failed");
+    bus_handle->defer_gpio = false;
+
+    /* Four frames for the whole bus: mode, data command (reset), clear,
+     * display control. */
+    if (init_config->flags.set_mode) {
+        _broadcast_frame(bus_handle, MODE_COMMAND(init_config->mode),
+                         NULL, 0);
+    }
+    _broadcast_frame(bus_handle, ADDRESS_INCREMENT, NULL, 0);
+    _broadcast_frame(bus_handle, DISPLAY_ADDRESS, blank, sizeof(blank));
+    _broadcast_frame(bus_handle,
+                     DISPLAY_CONTROL_COMMAND(init_config->flags.display_on,
+                                             init_config->pulse_width),
+                     NULL, 0);
+
+    tm1668_dev_handle_t item;
+    STAILQ_FOREACH(item, &bus_handle->device_list, next)
+    {
+        item->address_fixed = false;
+        item->display_on = init_config->flags.display_on;
+        item->pulse_width = PULSE_WIDTH_MASK & init_config->pulse_width;
+        if (init_config->flags.set_mode) {
+            _record_mode(item, init_config->mode);
+        }
+        portENTER_CRITICAL(&item->buf_lock);
+        memset(item->display, 0, sizeof(item->display));
+        item->dirty = 0;
+        item->resync = false;
+        portEXIT_CRITICAL(&item->buf_lock);
+    }
+
+out:
+    xSemaphoreGive(bus_handle->bus_lock_mux);
+    return ret;
+}
+#endif // CONFIG_TM1668_WITH_BUS
+
+esp_err_t tm1668_set_mode(tm1668_dev_handle_t handle, uint8_t value)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+
+    /* Display mode command: 0b00MMxxxx.
+     * Only valid on TM1668 (TM1638 ignores this command). */
+    tm1668_command_unchecked(handle, MODE_COMMAND(value));
+
+    return ESP_OK;
+}
+
+esp_err_t tm1668_set_pulse(tm1668_dev_handle_t handle, uint8_t value)
 {
     ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
                         "invalid device handle");
 
     /* Display control byte: 0b1000DPPP  (D=display on/off, PPP=pulse width). */
-    handle->pulse_width = value;
-    _send_command(handle, DISPLAY_CONTROL |
-                              (handle->display_on << DISPLAY_BIT) |
-                              (PULSE_WIDTH_MASK & handle->pulse_width));
+    handle->pulse_width = PULSE_WIDTH_MASK & value;
+    _send_command(handle, DISPLAY_CONTROL_COMMAND(handle->display_on,
+                                                  handle->pulse_width));
 
     return ESP_OK;
 }
@@ -557,9 +1488,185 @@ esp_err_t tm1668_display(tm1668_dev_handle_t handle, bool value)
 
     /* Pulse width is preserved from the last tm1668_set_pulse() call. */
     handle->display_on = value;
-    _send_command(handle, DISPLAY_CONTROL |
-                              (handle->display_on << DISPLAY_BIT) |
-                              (PULSE_WIDTH_MASK & handle->pulse_width));
+    _send_command(handle, DISPLAY_CONTROL_COMMAND(handle->display_on,
+                                                  handle->pulse_width));
+
+    return ESP_OK;
+}
+
+esp_err_t tm1668_get_timing(tm1668_dev_handle_t handle,
+                            tm1668_timing_t *ret_timing)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+    ESP_RETURN_ON_FALSE(ret_timing, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid timing pointer");
+
+    portENTER_CRITICAL(&tm1668_lock);
+    *ret_timing = BUS_HANDLE(handle)->timing;
+    portEXIT_CRITICAL(&tm1668_lock);
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Replace the bus timing between transactions.
+ *
+ * Holding both tm1668_lock and the timer engine keeps the choice between
+ * bit-banging and the engine stable for the duration of a transaction.
+ */
+static void _set_timing(tm1668_dev_handle_t handle,
+                        const tm1668_timing_t *timing)
+{
+    tm1668_engine_lock();
+    portENTER_CRITICAL(&tm1668_lock);
+    BUS_HANDLE(handle)->timing = *timing;
+    portEXIT_CRITICAL(&tm1668_lock);
+    tm1668_engine_unlock();
+}
+
+/** true if every delay is within 1..TIMING_MAX_US, STB times 0..TIMING_MAX_US. */
+static bool _timing_valid(const tm1668_timing_t *timing)
+{
+    return timing->write_delay_us >= 1 &&
+           timing->write_delay_us <= TIMING_MAX_US &&
+           timing->read_delay_us >= 1 &&
+           timing->read_delay_us <= TIMING_MAX_US &&
+           timing->read_key_delay_us >= 1 &&
+           timing->read_key_delay_us <= TIMING_MAX_US &&
+           timing->stb_setup_us <= TIMING_MAX_US &&
+           timing->stb_hold_us <= TIMING_MAX_US;
+}
+
+esp_err_t tm1668_set_timing(tm1668_dev_handle_t handle,
+                            const tm1668_timing_t *timing)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+    ESP_RETURN_ON_FALSE(timing && _timing_valid(timing), ESP_ERR_INVALID_ARG,
+                        TAG, "invalid timing");
+
+    _set_timing(handle, timing);
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Key scan for calibration: the bare bit-banged frame.
+ *
+ * Scans at deliberately marginal timings must not reach the key cache, the
+ * debouncer, reflex bindings, the latency tracer or the resync check.
+ */
+static void _probe_key(tm1668_dev_handle_t handle, uint8_t *data, size_t size)
+{
+    _urgent_enter();
+    _read_key_frame(handle, data, size);
+    _urgent_exit();
+}
+
+/** Scan `samples` times; true if every scan equals `ref`. */
+static bool _scans_match(tm1668_dev_handle_t handle, const uint8_t *ref,
+                         uint16_t samples)
+{
+    uint8_t key[KEY_CHECK_SIZE];
+    for (int i = 0; i < samples; i++) {
+        _probe_key(handle, key, sizeof(key));
+        if (memcmp(key, ref, sizeof(key)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+esp_err_t tm1668_calibrate(tm1668_dev_handle_t handle,
+                           const tm1668_calibrate_config_t *config,
+                           tm1668_timing_t *ret_timing)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+
+    uint16_t max_delay = DELAY_US * 4;
+    uint16_t samples = 16;
+    uint16_t margin = 0;
+    if (config) {
+        max_delay = config->max_delay_us ? config->max_delay_us : max_delay;
+        samples = config->samples ? config->samples : samples;
+        margin = config->margin_us;
+    }
+    ESP_RETURN_ON_FALSE(margin < TIMING_MAX_US && max_delay <= TIMING_MAX_US,
+                        ESP_ERR_INVALID_ARG, TAG,
+                        "invalid calibration margin/max delay");
+    if (max_delay > TIMING_MAX_US - margin) {
+        max_delay = TIMING_MAX_US - margin;
+    }
+
+    tm1668_timing_t saved;
+    tm1668_get_timing(handle, &saved);
+
+    /* Reference scan at the slowest timing. */
+    uint16_t max_settle = saved.read_key_delay_us > max_delay
+                              ? saved.read_key_delay_us
+                              : max_delay;
+    if (max_settle > TIMING_MAX_US - margin) {
+        max_settle = TIMING_MAX_US - margin;
+    }
+    /* STB setup and hold are not calibrated; keep the configured ones. */
+    tm1668_timing_t timing = {
+        .write_delay_us = max_delay,
+        .read_delay_us = max_delay,
+        .read_key_delay_us = max_settle,
+        .stb_setup_us = saved.stb_setup_us,
+        .stb_hold_us = saved.stb_hold_us,
+    };
+    _set_timing(handle, &timing);
+    uint8_t ref[KEY_CHECK_SIZE];
+    _probe_key(handle, ref, sizeof(ref));
+    bool ok = _scans_match(handle, ref, samples);
+    for (int n = 0; n < sizeof(ref); n++) {
+        ok = ok && !(ref[n] & KEY_CHECK_MASK);
+    }
+    if (!ok) {
+        _set_timing(handle, &saved);
+        ESP_LOGE(TAG, "key data unstable at %u us", max_delay);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    /* Fastest stable clock, keeping the slow settling delay... */
+    for (uint16_t d = 1; d < max_delay; d++) {
+        timing.write_delay_us = d;
+        timing.read_delay_us = d;
+        _set_timing(handle, &timing);
+        if (_scans_match(handle, ref, samples)) {
+            break;
+        }
+        timing.write_delay_us = max_delay;
+        timing.read_delay_us = max_delay;
+    }
+    /* ...then the shortest stable settling delay at that clock. */
+    for (uint16_t d = 1; d < max_settle; d++) {
+        timing.read_key_delay_us = d;
+        _set_timing(handle, &timing);
+        if (_scans_match(handle, ref, samples)) {
+            break;
+        }
+        timing.read_key_delay_us = max_settle;
+    }
+
+    timing.write_delay_us += margin;
+    timing.read_delay_us += margin;
+    timing.read_key_delay_us += margin;
+    if (!_timing_valid(&timing)) {
+        _set_timing(handle, &saved);
+        ESP_LOGE(TAG, "calibrated timing out of range");
+        return ESP_ERR_INVALID_STATE;
+    }
+    _set_timing(handle, &timing);
+    ESP_LOGI(TAG, "calibrated: write %u us, read %u us, settle %u us",
+             timing.write_delay_us, timing.read_delay_us,
+             timing.read_key_delay_us);
+    if (ret_timing) {
+        *ret_timing = timing;
+    }
 
     return ESP_OK;
 }
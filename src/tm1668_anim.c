@@ -0,0 +1,211 @@
+/**
+ * @file tm1668_anim.c
+ * @brief Timer-driven playback of display animations stored in flash.
+ *
+ * Each step stages the current frame straight from its source pointer into
+ * the device shadow with tm1668_display_buffer(), which compares byte by
+ * byte and marks only the changed addresses dirty; tm1668_flush() then
+ * sends the dirty span. The one-shot esp_timer is re-armed with the next
+ * frame's duration after every step, so frames may have different lengths.
+ *
+ * Every stop bumps the player's run number under its lock and stops the
+ * timer there. A step re-arms the timer under the same lock, and only
+ * within the run it stepped, so a callback still in flight when playback
+ * is stopped or replaced cannot start the timer again.
+ */
+
+#include "tm1668_anim.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "tm1668_priv.h"
+
+static const char TAG[] = "tm1668_anim";
+
+/**
+ * @brief Internal animation player structure.
+ */
+struct tm1668_anim_player_t {
+    tm1668_dev_handle_t device;    /**< Target device */
+    esp_timer_handle_t timer;      /**< One-shot frame timer */
+    tm1668_anim_done_cb_t on_done; /**< Completion callback */
+    void *user_ctx;                /**< Passed to on_done */
+    bool stage_only;               /**< Leave flushing to the caller */
+    portMUX_TYPE lock;             /**< Protects the fields below */
+    const tm1668_anim_t *anim;     /**< Playing animation, NULL when stopped */
+    size_t frame;                  /**< Index of the next frame to show */
+    bool loop;                     /**< Restart after the last frame */
+    uint32_t run;                  /**< Bumped by every stop */
+};
+
+static inline uint32_t _duration_ms(const tm1668_anim_t *anim, size_t frame)
+{
+    return anim->durations_ms ? anim->durations_ms[frame] : anim->frame_ms;
+}
+
+/**
+ * @brief Show the next frame and return its duration.
+ *
+ * @param[in]  handle Player handle.
+ * @param[out] done   Set to true if a non-looping animation just ended.
+ * @param[out] run    Receives the run the frame belongs to.
+ * @return Duration in ms, or 0 if playback has finished or was stopped.
+ */
+static uint32_t _step(tm1668_anim_player_handle_t handle, bool *done,
+                      uint32_t *run)
+{
+    portENTER_CRITICAL(&handle->lock);
+    *run = handle->run;
+    const tm1668_anim_t *anim = handle->anim;
+    size_t frame = handle->frame;
+    if (anim && frame >= anim->frame_count) {
+        if (handle->loop) {
+            frame = 0;
+        } else {
+            handle->anim = NULL;
+            *done = true;
+        }
+    }
+    anim = handle->anim;
+    if (anim) {
+        handle->frame = frame + 1;
+    }
+    portEXIT_CRITICAL(&handle->lock);
+    if (!anim) {
+        return 0;
+    }
+
+    tm1668_display_buffer(handle->device, anim->address,
+                          anim->data + frame * anim->frame_size,
+                          anim->frame_size);
+    if (!handle->stage_only) {
+        tm1668_flush(handle->device);
+    }
+    /* A zero duration would stop the player; show such frames for 1 ms. */
+    uint32_t ms = _duration_ms(anim, frame);
+    return ms ? ms : 1;
+}
+
+/**
+ * @brief Arm the timer for the next frame, unless the run was stopped.
+ *
+ * Another step of the same run may have armed it already (a callback that
+ * was in flight when tm1668_anim_play() started the run); that is not an
+ * error.
+ */
+static esp_err_t _arm(tm1668_anim_player_handle_t handle, uint32_t run,
+                      uint32_t ms)
+{
+    esp_err_t ret = ESP_OK;
+    portENTER_CRITICAL(&handle->lock);
+    if (handle->run == run && !esp_timer_is_active(handle->timer)) {
+        ret = esp_timer_start_once(handle->timer, (uint64_t)ms * 1000);
+    }
+    portEXIT_CRITICAL(&handle->lock);
+    return ret;
+}
+
+static void _timer_cb(void *arg)
+{
+    tm1668_anim_player_handle_t handle = arg;
+    bool done = false;
+    uint32_t run;
+    uint32_t ms = _step(handle, &done, &run);
+    if (ms) {
+        _arm(handle, run, ms);
+    } else if (done && handle->on_done) {
+        handle->on_done(handle, handle->user_ctx);
+    }
+}
+
+esp_err_t tm1668_new_anim_player(const tm1668_anim_player_config_t *config,
+                                 tm1668_anim_player_handle_t *ret_handle)
+{
+    ESP_RETURN_ON_FALSE(config && config->device, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid config");
+    ESP_RETURN_ON_FALSE(ret_handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid handle pointer");
+
+    esp_err_t ret = ESP_OK;
+    tm1668_anim_player_handle_t handle = (tm1668_anim_player_handle_t)calloc(
+        1, sizeof(struct tm1668_anim_player_t));
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_NO_MEM, TAG, "no memory for player");
+
+    handle->device = config->device;
+    handle->on_done = config->on_done;
+    handle->user_ctx = config->user_ctx;
+    handle->stage_only = config->flags.stage_only;
+    portMUX_INITIALIZE(&handle->lock);
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = _timer_cb,
+        .arg = handle,
+        .name = "tm1668_anim",
+    };
+    ESP_GOTO_ON_ERROR(esp_timer_create(&timer_args, &handle->timer), err, TAG,
+                      "create timer failed");
+
+    *ret_handle = handle;
+    return ESP_OK;
+
+err:
+    free(handle);
+    return ret;
+}
+
+esp_err_t tm1668_del_anim_player(tm1668_anim_player_handle_t handle)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid player handle");
+
+    /* A stop leaves nothing to re-arm the timer, so the delete only fails
+     * on a bad handle; retry while it reports the timer as running. */
+    esp_err_t ret;
+    do {
+        tm1668_anim_stop(handle);
+        ret = esp_timer_delete(handle->timer);
+    } while (ret == ESP_ERR_INVALID_STATE);
+    ESP_RETURN_ON_ERROR(ret, TAG, "delete timer failed");
+    free(handle);
+    return ESP_OK;
+}
+
+esp_err_t tm1668_anim_play(tm1668_anim_player_handle_t handle,
+                           const tm1668_anim_t *anim, bool loop)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid player handle");
+    ESP_RETURN_ON_FALSE(anim && anim->data && anim->frame_count > 0,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid animation");
+    ESP_RETURN_ON_FALSE(anim->frame_size > 0 &&
+                            anim->address + anim->frame_size <=
+                                DISPLAY_RAM_SIZE,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid frame size");
+
+    tm1668_anim_stop(handle);
+    portENTER_CRITICAL(&handle->lock);
+    handle->anim = anim;
+    handle->frame = 0;
+    handle->loop = loop;
+    portEXIT_CRITICAL(&handle->lock);
+
+    bool done = false;
+    uint32_t run;
+    uint32_t ms = _step(handle, &done, &run);
+    return _arm(handle, run, ms);
+}
+
+esp_err_t tm1668_anim_stop(tm1668_anim_player_handle_t handle)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid player handle");
+
+    portENTER_CRITICAL(&handle->lock);
+    handle->anim = NULL;
+    handle->run++;
+    /* Not running is fine; a callback already in flight sees the new run
+     * and leaves the timer alone. */
+    esp_timer_stop(handle->timer);
+    portEXIT_CRITICAL(&handle->lock);
+    return ESP_OK;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file tm1668_cost.c
+ * @brief Transaction cost estimates.
+ *
+ * The estimates replay the decisions of the write paths in tm1668.c — data
+ * command switches, unused-address clipping, burst merging, remapped grid
+ * pairs, resync — on the cached device state, and time every STB frame the
+ * way it will be clocked: bit-banged with busy waits or by the timer
+ * engine. The budgeted writes in tm1668.c use the same frame timing.
+ */
+
+#include "tm1668_cost.h"
+#include "esp_check.h"
+#include "tm1668_priv.h"
+
+static const char TAG[] = "tm1668_cost";
+
+/* GPIO overhead of a bit-banged clock cycle, on top of its delays. */
+#define CLOCK_NS CONFIG_TM1668_COST_CLOCK_NS
+
+void tm1668_cost_frame(tm1668_bus_handle_t bus, size_t tx_len, size_t rx_len,
+                       tm1668_cost_t *cost)
+{
+    const tm1668_timing_t *timing = &bus->timing;
+    uint32_t tx_clocks = tx_len * 8;
+    uint32_t rx_clocks = rx_len * 8;
+    uint32_t us;
+    if (_is_slow(bus)) {
+        /* One alarm per edge; the first comes after the STB setup, the
+         * hold after a write is at least a write half-cycle. */
+        us = (timing->stb_setup_us > timing->write_delay_us
+                  ? timing->stb_setup_us
+                  : timing->write_delay_us) +
+             (2 * tx_clocks - 1) * timing->write_delay_us;
+        if (rx_len) {
+            uint32_t wait =
+                (timing->read_key_delay_us + timing->read_delay_us - 1) /
+                timing->read_delay_us;
+            us += (wait + 2 * rx_clocks) * timing->read_delay_us +
+                  timing->stb_hold_us;
+        } else {
+            us += timing->stb_hold_us > timing->write_delay_us
+                      ? timing->stb_hold_us
+                      : timing->write_delay_us;
+        }
+    } else {
+        us = timing->stb_setup_us + 2 * tx_clocks * timing->write_delay_us +
+             timing->stb_hold_us +
+             ((tx_clocks + rx_clocks) * CLOCK_NS + 999) / 1000;
+        if (rx_len) {
+            us += timing->read_key_delay_us +
+                  2 * rx_clocks * timing->read_delay_us;
+        }
+    }
+    cost->frames++;
+    cost->clocks += tx_clocks + rx_clocks;
+    cost->us += us;
+}
+
+/**
+ * @brief Add the cost of sending display addresses as merged bursts.
+ *
+ * @param[in]     handle Device handle.
+ * @param[in]     mask   Chip addresses to send.
+ * @param[in]     used   Addresses driven in the current mode.
+ * @param[in,out] fixed  Cached fixed-address mode; cleared by the first
+ *                       burst.
+ * @param[in,out] cost   Cost to add to.
+ */
+static void _cost_runs(tm1668_dev_handle_t handle, uint16_t mask,
+                       uint16_t used, bool *fixed, tm1668_cost_t *cost)
+{
+    uint32_t rest = mask & used;
+    while (rest) {
+        uint8_t first;
+        size_t size = _next_run(&rest, &first);
+        if (*fixed) {
+            tm1668_cost_frame(BUS_HANDLE(handle), 1, 0, cost);
+            *fixed = false;
+        }
+        tm1668_cost_frame(BUS_HANDLE(handle), 1 + size, 0, cost);
+    }
+}
+
+esp_err_t tm1668_estimate_cost(tm1668_dev_handle_t handle, tm1668_cost_op_t op,
+                               uint8_t address, size_t size,
+                               tm1668_cost_t *ret_cost)
+{
+    ESP_RETURN_ON_FALSE(handle && ret_cost, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid argument");
+    ESP_RETURN_ON_FALSE(address < DISPLAY_RAM_SIZE &&
+                            size <= DISPLAY_RAM_SIZE - address,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid address/size");
+
+    portENTER_CRITICAL(&handle->buf_lock);
+    uint16_t dirty = handle->dirty;
+    uint16_t used = handle->used;
+    bool resync = handle->resync;
+    const tm1668_remap_t *remap = handle->remap;
+    portEXIT_CRITICAL(&handle->buf_lock);
+    bool fixed = handle->address_fixed;
+
+    tm1668_cost_t cost = {0};
+    switch (op) {
+    case TM1668_COST_DISPLAY_FIXED:
+        if (!remap) {
+            if (used & (1U << address)) {
+                if (!fixed) {
+                    tm1668_cost_frame(BUS_HANDLE(handle), 1, 0, &cost);
+                }
+                tm1668_cost_frame(BUS_HANDLE(handle), 2, 0, &cost);
+            }
+            break;
+        }
+        /* A remapped write is a flush of one more byte. */
+        size = 1;
+        /* fall through */
+    case TM1668_COST_DISPLAY_AUTO:
+        if (remap) {
+            dirty |= ADDRESS_RANGE(address, size);
+            _cost_runs(handle, _remap_dirty(remap, dirty), used, &fixed,
+                       &cost);
+        } else {
+            /* One burst, clipped to the driven addresses. */
+            _cost_runs(handle, ADDRESS_RANGE(address, size), used, &fixed,
+                       &cost);
+        }
+        break;
+    case TM1668_COST_FLUSH:
+        if (resync) {
+            if (used != 0xFFFF) {
+                tm1668_cost_frame(BUS_HANDLE(handle), 1, 0, &cost);
+            }
+            tm1668_cost_frame(BUS_HANDLE(handle), 1, 0, &cost);
+            fixed = false;
+            _cost_runs(handle, 0xFFFF, used, &fixed, &cost);
+            tm1668_cost_frame(BUS_HANDLE(handle), 1, 0, &cost);
+        } else {
+            _cost_runs(handle, remap ? _remap_dirty(remap, dirty) : dirty,
+                       used, &fixed, &cost);
+        }
+        break;
+    case TM1668_COST_READ_KEY:
+        tm1668_cost_frame(BUS_HANDLE(handle), 1, size, &cost);
+        break;
+    case TM1668_COST_COMMAND:
+        tm1668_cost_frame(BUS_HANDLE(handle), 1, 0, &cost);
+        break;
+    default:
+        ESP_RETURN_ON_FALSE(false, ESP_ERR_INVALID_ARG, TAG,
+                            "invalid operation");
+    }
+
+    *ret_cost = cost;
+    return ESP_OK;
+}
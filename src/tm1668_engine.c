@@ -0,0 +1,266 @@
+/**
+ * @file tm1668_engine.c
+ * @brief gptimer-driven bit engine for slow buses (CONFIG_TM1668_TIMER_ENGINE).
+ *
+ * With half-cycle delays of tens to hundreds of microseconds, bit-banging
+ * with esp_rom_delay_us() inside tm1668_lock keeps a core busy for
+ * milliseconds per frame. Here the calling task sets up one STB frame and
+ * blocks on a semaphore; a gptimer alarm fires every half cycle and its
+ * callback makes the next edge:
+ *
+ *   TX_LOW   CLK low, DIO = next bit      (write half-cycle)
+ *   TX_HIGH  CLK high: the chip latches
+ *   WAIT     DIO released, READ_KEY settling delay (read half-cycles)
+ *   RX_LOW   sample the previous bit, CLK low
+ *   RX_HIGH  CLK high
+ *   HOLD     CLK high until STB rises
+ *
+ * and finally releases DIO, raises STB and wakes the task. The first alarm
+ * comes after the longer of the write half-cycle and the STB setup time.
+ * After a write the hold lasts the longer of the write half-cycle and the
+ * STB hold time, so CLK stays high at least as long as when bit-banged;
+ * after a read a read half-cycle has already passed when the last bit is
+ * sampled, and only the STB hold time is added. Frames of all buses share
+ * the one timer and are serialized by the engine mutex, which also stands
+ * in for tm1668_lock on slow buses.
+ */
+
+#include "driver/gptimer.h"
+#include "esp_check.h"
+#include "tm1668_priv.h"
+
+#ifdef CONFIG_TM1668_TIMER_ENGINE
+
+static const char TAG[] = "tm1668_engine";
+
+/** Timer resolution: one tick per microsecond. */
+#define ENGINE_RESOLUTION_HZ 1000000
+
+/** Engine states, one per kind of timer alarm. */
+typedef enum {
+    STATE_TX_LOW,
+    STATE_TX_HIGH,
+    STATE_WAIT,
+    STATE_RX_LOW,
+    STATE_RX_HIGH,
+    STATE_HOLD,
+} engine_state_t;
+
+/**
+ * @brief The frame being clocked (owned by the engine mutex holder).
+ */
+typedef struct {
+    tm1668_bus_handle_t bus; /**< Bus being clocked */
+    uint64_t stb_mask;       /**< STB lines of the frame */
+    const uint8_t *tx;       /**< Bytes to send */
+    size_t tx_len;           /**< Number of bytes to send */
+    uint8_t *rx;             /**< Key bytes to read, zeroed */
+    size_t rx_len;           /**< Number of key bytes to read */
+    size_t bit;              /**< Bits sent, or bits clocked in */
+    uint32_t wait;           /**< Read half-cycles left in WAIT */
+    uint32_t write_delay_us; /**< Write half-cycle */
+    uint32_t read_delay_us;  /**< Read half-cycle */
+    uint32_t stb_hold_us;    /**< STB hold time, 0 = none */
+    engine_state_t state;    /**< Next edge */
+} engine_job_t;
+
+static portMUX_TYPE engine_init_lock = portMUX_INITIALIZER_UNLOCKED;
+static StaticSemaphore_t engine_mutex_buf;
+static StaticSemaphore_t engine_done_buf;
+static SemaphoreHandle_t engine_mutex; /**< Serializes frames */
+static SemaphoreHandle_t engine_done;  /**< Given when a frame ends */
+static gptimer_handle_t engine_timer;  /**< Created on first use */
+static engine_job_t job;
+
+/** Set the alarm period; auto-reload keeps it until changed. */
+static inline void _set_period(uint32_t us)
+{
+    const gptimer_alarm_config_t alarm = {
+        .alarm_count = us,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+    gptimer_set_alarm_action(engine_timer, &alarm);
+}
+
+/** Last edge of a frame: release DIO, raise STB, wake the task. */
+static bool _finish(engine_job_t *j)
+{
+    BaseType_t woken = pdFALSE;
+    _set_dio(j->bus, 1);
+    _set_stb_mask(j->stb_mask, 1);
+    gptimer_stop(engine_timer);
+    xSemaphoreGiveFromISR(engine_done, &woken);
+    return woken == pdTRUE;
+}
+
+/** After the last edge: hold for `us` (if any), then finish. */
+static bool _last_edge(engine_job_t *j, uint32_t us)
+{
+    if (!us) {
+        return _finish(j);
+    }
+    j->state = STATE_HOLD;
+    _set_period(us);
+    return false;
+}
+
+static bool _on_alarm(gptimer_handle_t timer,
+                      const gptimer_alarm_event_data_t *edata, void *user_ctx)
+{
+    engine_job_t *j = &job;
+    switch (j->state) {
+    case STATE_TX_LOW:
+        if (!j->bit) {
+            /* The first period may have been stretched to the STB setup. */
+            _set_period(j->write_delay_us);
+        }
+        _set_clk(j->bus, 0);
+        _set_dio(j->bus, (j->tx[j->bit / 8] >> (j->bit % 8)) & 1);
+        j->state = STATE_TX_HIGH;
+        break;
+    case STATE_TX_HIGH:
+        _set_clk(j->bus, 1);
+        if (++j->bit < j->tx_len * 8) {
+            j->state = STATE_TX_LOW;
+        } else if (!j->rx_len) {
+            return _last_edge(j, j->stb_hold_us > j->write_delay_us
+                                     ? j->stb_hold_us
+                                     : j->write_delay_us);
+        } else {
+            j->bit = 0;
+            j->state = STATE_WAIT;
+            _set_period(j->read_delay_us);
+        }
+        break;
+    case STATE_WAIT:
+        _set_dio(j->bus, 1);
+        if (j->wait > 1) {
+            j->wait--;
+            break;
+        }
+        j->state = STATE_RX_LOW;
+        /* fall through */
+    case STATE_RX_LOW:
+        if (j->bit) {
+            size_t b = j->bit - 1;
+            j->rx[b / 8] |= _get_dio(j->bus) << (b % 8);
+        }
+        if (j->bit == j->rx_len * 8) {
+            return _last_edge(j, j->stb_hold_us);
+        }
+        _set_clk(j->bus, 0);
+        j->state = STATE_RX_HIGH;
+        break;
+    case STATE_RX_HIGH:
+        _set_clk(j->bus, 1);
+        j->bit++;
+        j->state = STATE_RX_LOW;
+        break;
+    case STATE_HOLD:
+        return _finish(j);
+    }
+    return false;
+}
+
+/** Create the timer on first use; caller owns the engine. */
+static esp_err_t _timer_init(void)
+{
+    if (engine_timer) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = ESP_OK;
+    const gptimer_config_t config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = ENGINE_RESOLUTION_HZ,
+    };
+    ESP_RETURN_ON_ERROR(gptimer_new_timer(&config, &engine_timer), TAG,
+                        "create timer failed");
+    const gptimer_event_callbacks_t callbacks = {.on_alarm = _on_alarm};
+    ESP_GOTO_ON_ERROR(
+        gptimer_register_event_callbacks(engine_timer, &callbacks, NULL), err,
+        TAG, "register timer callback failed");
+    ESP_GOTO_ON_ERROR(gptimer_enable(engine_timer), err, TAG,
+                      "enable timer failed");
+    return ESP_OK;
+
+err:
+    gptimer_del_timer(engine_timer);
+    engine_timer = NULL;
+    return ret;
+}
+
+void tm1668_engine_lock(void)
+{
+    /* Static storage: creating the semaphores cannot fail or allocate. */
+    portENTER_CRITICAL(&engine_init_lock);
+    if (!engine_mutex) {
+        engine_done = xSemaphoreCreateBinaryStatic(&engine_done_buf);
+        engine_mutex = xSemaphoreCreateMutexStatic(&engine_mutex_buf);
+    }
+    portEXIT_CRITICAL(&engine_init_lock);
+    xSemaphoreTake(engine_mutex, portMAX_DELAY);
+}
+
+void tm1668_engine_unlock(void)
+{
+    xSemaphoreGive(engine_mutex);
+}
+
+bool tm1668_engine_begin(tm1668_bus_handle_t bus)
+{
+    /* Fast buses never touch the mutex. The timing is read again below,
+     * where it cannot change (_set_timing() takes the engine too). */
+    if (!_is_slow(bus)) {
+        return false;
+    }
+    tm1668_engine_lock();
+    /* Without a timer, fall back to bit-banging. */
+    if (_is_slow(bus) && _timer_init() == ESP_OK) {
+        return true;
+    }
+    tm1668_engine_unlock();
+    return false;
+}
+
+void tm1668_engine_frame(tm1668_bus_handle_t bus, uint64_t stb_mask,
+                         const uint8_t *tx, size_t tx_len, uint8_t *rx,
+                         size_t rx_len)
+{
+    const tm1668_timing_t *timing = &bus->timing;
+    job = (engine_job_t){
+        .bus = bus,
+        .stb_mask = stb_mask,
+        .tx = tx,
+        .tx_len = tx_len,
+        .rx = rx,
+        .rx_len = rx_len,
+        .wait = (timing->read_key_delay_us + timing->read_delay_us - 1) /
+                timing->read_delay_us,
+        .write_delay_us = timing->write_delay_us,
+        .read_delay_us = timing->read_delay_us,
+        .stb_hold_us = timing->stb_hold_us,
+        .state = STATE_TX_LOW,
+    };
+    if (rx_len) {
+        memset(rx, 0, rx_len);
+        /* Open-drain for the whole frame: the command goes out slowly
+         * anyway, and the chip may drive DIO right after it. */
+        _set_dio_od(bus, true);
+    }
+
+    _set_stb_mask(stb_mask, 0);
+    gptimer_set_raw_count(engine_timer, 0);
+    _set_period(timing->stb_setup_us > timing->write_delay_us
+                    ? timing->stb_setup_us
+                    : timing->write_delay_us);
+    gptimer_start(engine_timer);
+    xSemaphoreTake(engine_done, portMAX_DELAY);
+    if (rx_len) {
+        _set_dio_od(bus, false);
+    }
+}
+
+#endif // CONFIG_TM1668_TIMER_ENGINE
@@ -0,0 +1,233 @@
+/**
+ * @file tm1668_gfx.c
+ * @brief Monochrome bitmap graphics for LED matrices.
+ *
+ * Rows are 16-bit words, so every drawing operation shifts and masks whole
+ * rows. Only the conversion to display RAM deals with the chip layout: grid
+ * rows are a plain copy, grid columns an 8 × 8 bit transpose per display
+ * byte half.
+ */
+
+#include "tm1668_gfx.h"
+#include "esp_check.h"
+#include "tm1668_priv.h"
+
+static const char TAG[] = "tm1668_gfx";
+
+esp_err_t tm1668_gfx_init(tm1668_gfx_t *gfx, tm1668_gfx_layout_t layout,
+                          uint8_t grids, uint8_t segments)
+{
+    ESP_RETURN_ON_FALSE(gfx, ESP_ERR_INVALID_ARG, TAG, "invalid bitmap");
+    ESP_RETURN_ON_FALSE(layout == TM1668_GFX_GRID_ROWS ||
+                            layout == TM1668_GFX_GRID_COLUMNS,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid layout");
+    ESP_RETURN_ON_FALSE(grids && grids <= DISPLAY_RAM_SIZE / 2 && segments &&
+                            segments <= TM1668_GFX_MAX,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid matrix size");
+
+    memset(gfx, 0, sizeof(*gfx));
+    gfx->layout = layout;
+    gfx->grids = grids;
+    gfx->segments = segments;
+    if (layout == TM1668_GFX_GRID_ROWS) {
+        gfx->width = segments;
+        gfx->height = grids;
+    } else {
+        gfx->width = grids;
+        gfx->height = segments;
+    }
+    return ESP_OK;
+}
+
+void tm1668_gfx_clear(tm1668_gfx_t *gfx)
+{
+    memset(gfx->rows, 0, sizeof(gfx->rows));
+}
+
+/** Shift a row left by x (right if negative); bits past 32 are dropped. */
+static inline uint32_t _shift(uint32_t bits, int x)
+{
+    if (x >= 0) {
+        return x < 32 ? bits << x : 0;
+    }
+    return x > -32 ? bits >> -x : 0;
+}
+
+/** Bits of the columns that exist in the bitmap. */
+static inline uint32_t _width_mask(const tm1668_gfx_t *gfx)
+{
+    return (1UL << gfx->width) - 1;
+}
+
+/** Set or clear the bits of mask in row y, if the row exists. */
+static inline void _apply(tm1668_gfx_t *gfx, int y, uint32_t mask, bool on)
+{
+    if (y < 0 || y >= gfx->height) {
+        return;
+    }
+    mask &= _width_mask(gfx);
+    if (on) {
+        gfx->rows[y] |= mask;
+    } else {
+        gfx->rows[y] &= ~mask;
+    }
+}
+
+void tm1668_gfx_pixel(tm1668_gfx_t *gfx, int x, int y, bool on)
+{
+    if (x >= 0 && x < gfx->width) {
+        _apply(gfx, y, 1UL << x, on);
+    }
+}
+
+bool tm1668_gfx_get_pixel(const tm1668_gfx_t *gfx, int x, int y)
+{
+    if (x < 0 || x >= gfx->width || y < 0 || y >= gfx->height) {
+        return false;
+    }
+    return (gfx->rows[y] >> x) & 1;
+}
+
+void tm1668_gfx_line(tm1668_gfx_t *gfx, int x0, int y0, int x1, int y1,
+                     bool on)
+{
+    /* Bresenham, collecting the pixels of each row into one mask. */
+    int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+    int dy = y1 > y0 ? y0 - y1 : y1 - y0;
+    int sx = x0 < x1 ? 1 : -1;
+    int sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    int row = y0;
+    uint32_t span = 0;
+    for (;;) {
+        if (x0 >= 0 && x0 < gfx->width) {
+            span |= 1UL << x0;
+        }
+        if (x0 == x1 && y0 == y1) {
+            break;
+        }
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y0 += sy;
+        }
+        if (y0 != row) {
+            _apply(gfx, row, span, on);
+            span = 0;
+            row = y0;
+        }
+    }
+    _apply(gfx, row, span, on);
+}
+
+void tm1668_gfx_blit(tm1668_gfx_t *gfx, int x, int y, const uint16_t *src,
+                     uint8_t width, uint8_t height, tm1668_gfx_op_t op)
+{
+    uint32_t src_mask = (1UL << width) - 1;
+    uint32_t mask = _shift(src_mask, x) & _width_mask(gfx);
+    for (int n = 0; n < height; n++) {
+        if (y + n < 0 || y + n >= gfx->height) {
+            continue;
+        }
+        uint16_t *row = &gfx->rows[y + n];
+        uint32_t bits = _shift(src[n] & src_mask, x) & mask;
+        switch (op) {
+        case TM1668_GFX_COPY:
+            *row = (*row & ~mask) | bits;
+            break;
+        case TM1668_GFX_OR:
+            *row |= bits;
+            break;
+        case TM1668_GFX_CLEAR:
+            *row &= ~bits;
+            break;
+        case TM1668_GFX_XOR:
+            *row ^= bits;
+            break;
+        }
+    }
+}
+
+void tm1668_gfx_sprite(tm1668_gfx_t *gfx, const tm1668_sprite_t *sprite,
+                       int x, int y)
+{
+    uint32_t src_mask = (1UL << sprite->width) - 1;
+    uint32_t clip = _shift(src_mask, x) & _width_mask(gfx);
+    for (int n = 0; n < sprite->height; n++) {
+        if (y + n < 0 || y + n >= gfx->height) {
+            continue;
+        }
+        uint16_t *row = &gfx->rows[y + n];
+        uint32_t opaque = sprite->mask ? sprite->mask[n] : sprite->rows[n];
+        opaque = _shift(opaque & src_mask, x) & clip;
+        *row = (*row & ~opaque) | (_shift(sprite->rows[n], x) & opaque);
+    }
+}
+
+/**
+ * @brief Transpose an 8 × 8 bit matrix: bit j of byte i becomes bit i of
+ *        byte j (three swap steps of 1, 2 and 4 bit blocks).
+ */
+static uint64_t _transpose8(uint64_t x)
+{
+    uint64_t t;
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+    x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+void tm1668_gfx_render(const tm1668_gfx_t *gfx, uint8_t *out)
+{
+    uint32_t seg = (1UL << gfx->segments) - 1;
+    if (gfx->layout == TM1668_GFX_GRID_ROWS) {
+        for (int g = 0; g < gfx->grids; g++) {
+            out[2 * g] = gfx->rows[g] & seg;
+            out[2 * g + 1] = (gfx->rows[g] & seg) >> 8;
+        }
+        return;
+    }
+
+    /* Rows 0–7 are SEG1–SEG8 (even bytes), rows 8–15 SEG9–SEG16. */
+    uint64_t lo = 0, hi = 0;
+    for (int y = 0; y < 8; y++) {
+        lo |= (uint64_t)(gfx->rows[y] & 0xFF) << (8 * y);
+        hi |= (uint64_t)(gfx->rows[y + 8] & 0xFF) << (8 * y);
+    }
+    lo = _transpose8(lo);
+    hi = _transpose8(hi);
+    for (int g = 0; g < gfx->grids; g++) {
+        out[2 * g] = (lo >> (8 * g)) & seg;
+        out[2 * g + 1] = (hi >> (8 * g)) & (seg >> 8);
+    }
+}
+
+esp_err_t tm1668_gfx_stage(tm1668_dev_handle_t handle,
+                           const tm1668_gfx_t *gfx)
+{
+    ESP_RETURN_ON_FALSE(handle && gfx, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid argument");
+
+    uint8_t buf[DISPLAY_RAM_SIZE];
+    tm1668_gfx_render(gfx, buf);
+    uint32_t seg = (1UL << gfx->segments) - 1;
+    const uint8_t mask[2] = {seg & 0xFF, seg >> 8};
+    portENTER_CRITICAL(&handle->buf_lock);
+    for (int n = 0; n < 2 * gfx->grids; n++) {
+        uint8_t value = (handle->display[n] & ~mask[n & 1]) | buf[n];
+        if (handle->display[n] != value) {
+            handle->display[n] = value;
+            handle->dirty |= 1U << n;
+        }
+    }
+    portEXIT_CRITICAL(&handle->buf_lock);
+
+    return ESP_OK;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file tm1668_latency.c
+ * @brief Key-to-display latency tracer (CONFIG_TM1668_LATENCY).
+ *
+ * The per-device state lives in struct tm1668_dev_t and is protected by the
+ * device's buf_lock, like the key cache it is updated with. The hooks are
+ * called from the key and display paths through the LATENCY_* macros of
+ * tm1668_priv.h, which compile to nothing when the tracer is disabled.
+ */
+
+#include "tm1668_latency.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "tm1668_priv.h"
+
+#ifdef CONFIG_TM1668_LATENCY
+
+static const char TAG[] = "tm1668_latency";
+
+void tm1668_latency_key(tm1668_dev_handle_t handle, const uint8_t *data,
+                        size_t size)
+{
+    /* Caller holds buf_lock and has not yet updated the key cache. */
+    if (!handle->latency.pending && memcmp(handle->key, data, size) != 0) {
+        handle->latency.pending = true;
+        handle->latency.key_us = esp_timer_get_time();
+    }
+}
+
+void tm1668_latency_sent(tm1668_dev_handle_t handle)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&handle->buf_lock);
+    struct tm1668_latency_t *l = &handle->latency;
+    if (l->tagged) {
+        if (l->pending) {
+            uint64_t us = now - l->key_us;
+            uint32_t latency = us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+            tm1668_latency_stats_t *st = &l->stats;
+            st->min_us = st->count && st->min_us < latency ? st->min_us
+                                                           : latency;
+            st->max_us = st->max_us > latency ? st->max_us : latency;
+            st->total_us += latency;
+            st->count++;
+            int bucket = latency ? 31 - __builtin_clz(latency) : 0;
+            if (bucket >= TM1668_LATENCY_BUCKETS) {
+                bucket = TM1668_LATENCY_BUCKETS - 1;
+            }
+            st->hist[bucket]++;
+        }
+        l->tagged = false;
+        l->pending = false;
+    }
+    portEXIT_CRITICAL(&handle->buf_lock);
+}
+
+esp_err_t tm1668_latency_tag(tm1668_dev_handle_t handle)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+
+    portENTER_CRITICAL(&handle->buf_lock);
+    handle->latency.tagged = true;
+    portEXIT_CRITICAL(&handle->buf_lock);
+    return ESP_OK;
+}
+
+esp_err_t tm1668_latency_get(tm1668_dev_handle_t handle,
+                             tm1668_latency_stats_t *ret_stats)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+    ESP_RETURN_ON_FALSE(ret_stats, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid stats pointer");
+
+    portENTER_CRITICAL(&handle->buf_lock);
+    *ret_stats = handle->latency.stats;
+    portEXIT_CRITICAL(&handle->buf_lock);
+    return ESP_OK;
+}
+
+esp_err_t tm1668_latency_reset(tm1668_dev_handle_t handle)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+
+    portENTER_CRITICAL(&handle->buf_lock);
+    memset(&handle->latency, 0, sizeof(handle->latency));
+    portEXIT_CRITICAL(&handle->buf_lock);
+    return ESP_OK;
+}
+
+#else // CONFIG_TM1668_LATENCY
+
+esp_err_t tm1668_latency_tag(tm1668_dev_handle_t handle)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t tm1668_latency_get(tm1668_dev_handle_t handle,
+                             tm1668_latency_stats_t *ret_stats)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t tm1668_latency_reset(tm1668_dev_handle_t handle)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_TM1668_LATENCY
+
+uint32_t tm1668_latency_percentile(const tm1668_latency_stats_t *stats,
+                                   uint8_t percent)
+{
+    if (!stats || !stats->count) {
+        return 0;
+    }
+    /* Rank of the percentile, rounded up, in 1..count. */
+    uint64_t rank = ((uint64_t)stats->count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (int i = 0; i < TM1668_LATENCY_BUCKETS; i++) {
+        seen += stats->hist[i];
+        if (seen >= rank && i < TM1668_LATENCY_BUCKETS - 1) {
+            uint32_t edge = (2U << i) - 1;
+            return edge < stats->max_us ? edge : stats->max_us;
+        }
+    }
+    return stats->max_us;
+}
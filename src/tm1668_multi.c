@@ -0,0 +1,374 @@
+/**
+ * @file tm1668_multi.c
+ * @brief Bit-sliced parallel transmit across several independent buses.
+ *
+ * Each data byte column (byte n of every device) is first sliced into eight
+ * GPIO masks, one per bit position, holding the DIO bits of the devices
+ * whose byte has that bit set. Clocking a bit is then:
+ *
+ *   W1TC = CLK | (DIO & ~ones[b])    CLK low, zero bits low
+ *   W1TS = ones[b]                   one bits released high
+ *   W1TS = CLK                       rising edge: all chips latch
+ *
+ * The set/clear registers are used rather than a read-modify-write of
+ * GPIO_OUT_REG so that other pins in the bank are never disturbed.
+ *
+ * Key reads run the other way round: after the common READ_KEY command the
+ * DIO lines are released, GPIO_IN_REG is sampled once per clock into eight
+ * masks, and each device's byte is gathered back from its DIO bit.
+ *
+ * Timer-engine frames on slow buses hold only the engine and give up the
+ * CPU between edges, so every group transfer takes the engine before
+ * tm1668_lock: no engine frame can run on a bus of the group meanwhile.
+ */
+
+#include "tm1668_multi.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "soc/gpio_reg.h"
+#include "soc/soc.h"
+#include "tm1668_priv.h"
+
+static const char TAG[] = "tm1668_multi";
+
+/** Pins of a group must be in the first GPIO output register bank. */
+#define MULTI_PIN_LIMIT 32
+
+/**
+ * @brief Internal multi-bus group structure.
+ */
+struct tm1668_multi_t {
+    size_t device_num; /**< Number of devices */
+    tm1668_dev_handle_t devices[TM1668_MULTI_MAX_DEVICES]; /**< Devices */
+    uint32_t dio_bit[TM1668_MULTI_MAX_DEVICES]; /**< DIO mask per device */
+    uint32_t clk_mask; /**< All CLK pins */
+    uint32_t dio_mask; /**< All DIO pins */
+    uint32_t stb_mask; /**< All STB pins */
+};
+
+/**
+ * @brief Slice one byte column into per-bit DIO masks.
+ *
+ * @param[in]  handle Group handle.
+ * @param[in]  data   Per-device data pointers.
+ * @param[in]  n      Byte index into each device's data.
+ * @param[out] ones   ones[b]: DIO pins to drive high for bit b.
+ */
+static inline void _slice(const struct tm1668_multi_t *handle,
+                          const uint8_t *const data[], size_t n,
+                          uint32_t ones[8])
+{
+    for (int b = 0; b < 8; b++) {
+        ones[b] = 0;
+    }
+    for (int i = 0; i < handle->device_num; i++) {
+        uint8_t value = data[i][n];
+        for (int b = 0; b < 8; b++) {
+            if ((value >> b) & 1) {
+                ones[b] |= handle->dio_bit[i];
+            }
+        }
+    }
+}
+
+/** Slice a byte that is the same for every device (command/address). */
+static inline void _slice_common(const struct tm1668_multi_t *handle,
+                                 uint8_t value, uint32_t ones[8])
+{
+    for (int b = 0; b < 8; b++) {
+        ones[b] = ((value >> b) & 1) ? handle->dio_mask : 0;
+    }
+}
+
+/**
+ * @brief Slowest timing over the buses of the group.
+ *
+ * The buses are clocked together, so each delay must satisfy every bus.
+ * Caller must hold tm1668_lock.
+ */
+static inline tm1668_timing_t _group_timing(const struct tm1668_multi_t *handle)
+{
+    tm1668_timing_t timing = {0};
+    for (int i = 0; i < handle->device_num; i++) {
+        const tm1668_timing_t *t = &BUS_HANDLE(handle->devices[i])->timing;
+        if (t->write_delay_us > timing.write_delay_us) {
+            timing.write_delay_us = t->write_delay_us;
+        }
+        if (t->read_delay_us > timing.read_delay_us) {
+            timing.read_delay_us = t->read_delay_us;
+        }
+        if (t->read_key_delay_us > timing.read_key_delay_us) {
+            timing.read_key_delay_us = t->read_key_delay_us;
+        }
+        if (t->stb_setup_us > timing.stb_setup_us) {
+            timing.stb_setup_us = t->stb_setup_us;
+        }
+        if (t->stb_hold_us > timing.stb_hold_us) {
+            timing.stb_hold_us = t->stb_hold_us;
+        }
+    }
+    return timing;
+}
+
+/**
+ * @brief Clock one sliced byte out on every bus (LSB first).
+ *
+ * Mirrors _send_data(): after the 8 bits all DIO lines are released high.
+ */
+static inline void _send_slices(const struct tm1668_multi_t *handle,
+                                const uint32_t ones[8], uint16_t delay_us)
+{
+    for (int b = 0; b < 8; b++) {
+        REG_WRITE(GPIO_OUT_W1TC_REG,
+                  handle->clk_mask | (handle->dio_mask & ~ones[b]));
+        REG_WRITE(GPIO_OUT_W1TS_REG, ones[b]);
+        TRACE_MASK(handle->clk_mask, TM1668_TRACE_CLK, 0);
+        TRACE_MASK(handle->dio_mask & ~ones[b], TM1668_TRACE_DIO, 0);
+        TRACE_MASK(ones[b], TM1668_TRACE_DIO, 1);
+        esp_rom_delay_us(delay_us);
+        REG_WRITE(GPIO_OUT_W1TS_REG, handle->clk_mask);
+        TRACE_MASK(handle->clk_mask, TM1668_TRACE_CLK, 1);
+        esp_rom_delay_us(delay_us);
+    }
+    REG_WRITE(GPIO_OUT_W1TS_REG, handle->dio_mask);
+    TRACE_MASK(handle->dio_mask, TM1668_TRACE_DIO, 1);
+}
+
+/** Drive every STB line of the group, with the STB setup / hold time. */
+static inline void _set_stb_all(const struct tm1668_multi_t *handle,
+                                const tm1668_timing_t *timing, uint32_t level)
+{
+    if (level) {
+        esp_rom_delay_us(timing->stb_hold_us);
+    }
+    REG_WRITE(level ? GPIO_OUT_W1TS_REG : GPIO_OUT_W1TC_REG, handle->stb_mask);
+    TRACE_MASK(handle->stb_mask, TM1668_TRACE_STB, level);
+    if (!level) {
+        esp_rom_delay_us(timing->stb_setup_us);
+    }
+}
+
+/** Send one command byte to every device (STB-low framing). */
+static inline void _command_frame_all(const struct tm1668_multi_t *handle,
+                                      uint8_t command,
+                                      const tm1668_timing_t *timing)
+{
+    uint32_t ones[8];
+    _slice_common(handle, command, ones);
+    _set_stb_all(handle, timing, 0);
+    _send_slices(handle, ones, timing->write_delay_us);
+    _set_stb_all(handle, timing, 1);
+}
+
+esp_err_t tm1668_new_multi(const tm1668_multi_config_t *config,
+                           tm1668_multi_handle_t *ret_handle)
+{
+    ESP_RETURN_ON_FALSE(config && config->devices, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid config");
+    ESP_RETURN_ON_FALSE(config->device_num > 0 &&
+                            config->device_num <= TM1668_MULTI_MAX_DEVICES,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid device number");
+    ESP_RETURN_ON_FALSE(ret_handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid handle pointer");
+
+    esp_err_t ret = ESP_OK;
+    tm1668_multi_handle_t handle =
+        (tm1668_multi_handle_t)calloc(1, sizeof(struct tm1668_multi_t));
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_NO_MEM, TAG, "no memory for group");
+
+    for (int i = 0; i < config->device_num; i++) {
+        tm1668_dev_handle_t dev = config->devices[i];
+        ESP_GOTO_ON_FALSE(dev, ESP_ERR_INVALID_ARG, err, TAG,
+                          "invalid device handle");
+        gpio_num_t clk = BUS_HANDLE(dev)->clk_num;
+        gpio_num_t dio = BUS_HANDLE(dev)->dio_num;
+        ESP_GOTO_ON_FALSE(clk < MULTI_PIN_LIMIT && dio < MULTI_PIN_LIMIT &&
+                              dev->stb_num < MULTI_PIN_LIMIT,
+                          ESP_ERR_INVALID_ARG, err, TAG,
+                          "pins must be GPIO0-GPIO31");
+        ESP_GOTO_ON_FALSE(!(handle->dio_mask & (1UL << dio)),
+                          ESP_ERR_INVALID_ARG, err, TAG,
+                          "devices must not share a DIO line");
+        handle->devices[i] = dev;
+        handle->dio_bit[i] = 1UL << dio;
+        handle->clk_mask |= 1UL << clk;
+        handle->dio_mask |= 1UL << dio;
+        handle->stb_mask |= 1UL << dev->stb_num;
+    }
+    handle->device_num = config->device_num;
+
+    *ret_handle = handle;
+    return ESP_OK;
+
+err:
+    free(handle);
+    return ret;
+}
+
+esp_err_t tm1668_del_multi(tm1668_multi_handle_t handle)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid group handle");
+
+    free(handle);
+    return ESP_OK;
+}
+
+esp_err_t tm1668_multi_display_auto(tm1668_multi_handle_t handle,
+                                    uint8_t address,
+                                    const uint8_t *const data[], size_t size)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid group handle");
+    ESP_RETURN_ON_FALSE(data, ESP_ERR_INVALID_ARG, TAG, "invalid data pointer");
+    ESP_RETURN_ON_FALSE(address < 0x10, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid address");
+    ESP_RETURN_ON_FALSE(address + size <= 0x10, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid size");
+
+    uint16_t used = 0;
+    uint16_t span = ADDRESS_RANGE(address, size);
+    uint8_t frames[TM1668_MULTI_MAX_DEVICES][DISPLAY_RAM_SIZE];
+    for (int i = 0; i < handle->device_num; i++) {
+        tm1668_dev_handle_t dev = handle->devices[i];
+        _store(dev, address, data[i], size);
+        used |= dev->used;
+        if (dev->remap) {
+            /* The logical bytes land on other chip grids: send the chip
+             * frame over every address that any device needs. */
+            uint8_t logical[DISPLAY_RAM_SIZE];
+            portENTER_CRITICAL(&dev->buf_lock);
+            memcpy(logical, dev->display, DISPLAY_RAM_SIZE);
+            portEXIT_CRITICAL(&dev->buf_lock);
+            tm1668_remap_frame(dev->remap, logical, frames[i]);
+            span |= _remap_dirty(dev->remap, ADDRESS_RANGE(address, size));
+        } else {
+            portENTER_CRITICAL(&dev->buf_lock);
+            memcpy(frames[i], dev->display, DISPLAY_RAM_SIZE);
+            portEXIT_CRITICAL(&dev->buf_lock);
+        }
+    }
+    /* Skip the tail that no device of the group drives in its mode. */
+    span &= used;
+    if (!span) {
+        return ESP_OK;
+    }
+    address = __builtin_ctz(span);
+    size = 32 - __builtin_clz(span) - address;
+    const uint8_t *rows[TM1668_MULTI_MAX_DEVICES];
+    for (int i = 0; i < handle->device_num; i++) {
+        rows[i] = &frames[i][address];
+    }
+
+    /* Like _display_bulk(): end the burst at a byte boundary when an
+     * urgent transaction is queued, step aside, and resume with a new
+     * address command. The engine stays taken, so the timing holds. */
+    uint32_t ones[8];
+    bool yield = true;
+    size_t n = 0;
+    tm1668_engine_lock();
+    portENTER_CRITICAL(&tm1668_lock);
+    const tm1668_timing_t timing = _group_timing(handle);
+    for (;;) {
+        /* Devices already in auto-increment mode just get the command
+         * again; an urgent fixed-address write may have run in between. */
+        bool any_fixed = false;
+        for (int i = 0; i < handle->device_num; i++) {
+            any_fixed |= handle->devices[i]->address_fixed;
+        }
+        if (any_fixed) {
+            _command_frame_all(handle, ADDRESS_INCREMENT, &timing);
+            for (int i = 0; i < handle->device_num; i++) {
+                handle->devices[i]->address_fixed = false;
+            }
+        }
+
+        _set_stb_all(handle, &timing, 0);
+        _slice_common(handle, ADDRESS_COMMAND(address + n), ones);
+        _send_slices(handle, ones, timing.write_delay_us);
+        do {
+            _slice(handle, rows, n++, ones);
+            _send_slices(handle, ones, timing.write_delay_us);
+        } while (n < size && !(yield && tm1668_urgent));
+        _set_stb_all(handle, &timing, 1);
+        if (n == size) {
+            break;
+        }
+        portEXIT_CRITICAL(&tm1668_lock);
+        /* Give up splitting for this transfer if the waiter never came. */
+        yield = _yield_to_urgent();
+        portENTER_CRITICAL(&tm1668_lock);
+    }
+    portEXIT_CRITICAL(&tm1668_lock);
+    tm1668_engine_unlock();
+
+    for (int i = 0; i < handle->device_num; i++) {
+        LATENCY_SENT(handle->devices[i]);
+    }
+
+    return ESP_OK;
+}
+
+/** Gather one device's byte out of eight sampled input masks. */
+static inline uint8_t _unslice(uint32_t dio_bit, const uint32_t samples[8])
+{
+    uint8_t value = 0;
+    for (int b = 0; b < 8; b++) {
+        if (samples[b] & dio_bit) {
+            value |= 1 << b;
+        }
+    }
+    return value;
+}
+
+esp_err_t tm1668_multi_read_key(tm1668_multi_handle_t handle,
+                                uint8_t *const data[], size_t size)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid group handle");
+    ESP_RETURN_ON_FALSE(data, ESP_ERR_INVALID_ARG, TAG, "invalid data pointer");
+    ESP_RETURN_ON_FALSE(size <= 0x10, ESP_ERR_INVALID_ARG, TAG, "invalid size");
+
+    uint32_t samples[8];
+    tm1668_engine_lock();
+    _urgent_enter();
+    tm1668_timing_t timing = _group_timing(handle);
+    /* Open-drain for the whole frame on push-pull buses. */
+    for (int i = 0; i < handle->device_num; i++) {
+        _set_dio_od(BUS_HANDLE(handle->devices[i]), true);
+    }
+    _set_stb_all(handle, &timing, 0);
+    _slice_common(handle, READ_KEY, samples);
+    /* Leaves every DIO released. */
+    _send_slices(handle, samples, timing.write_delay_us);
+    esp_rom_delay_us(timing.read_key_delay_us);
+    for (int n = 0; n < size; n++) {
+        for (int b = 0; b < 8; b++) {
+            REG_WRITE(GPIO_OUT_W1TC_REG, handle->clk_mask);
+            TRACE_MASK(handle->clk_mask, TM1668_TRACE_CLK, 0);
+            esp_rom_delay_us(timing.read_delay_us);
+            REG_WRITE(GPIO_OUT_W1TS_REG, handle->clk_mask);
+            TRACE_MASK(handle->clk_mask, TM1668_TRACE_CLK, 1);
+            esp_rom_delay_us(timing.read_delay_us);
+            samples[b] = REG_READ(GPIO_IN_REG);
+            TRACE_MASK(handle->dio_mask & ~samples[b], TM1668_TRACE_DIO, 0);
+            TRACE_MASK(handle->dio_mask & samples[b], TM1668_TRACE_DIO, 1);
+        }
+        for (int i = 0; i < handle->device_num; i++) {
+            data[i][n] = _unslice(handle->dio_bit[i], samples);
+        }
+    }
+    _set_stb_all(handle, &timing, 1);
+    for (int i = 0; i < handle->device_num; i++) {
+        _set_dio_od(BUS_HANDLE(handle->devices[i]), false);
+    }
+    _urgent_exit();
+    tm1668_engine_unlock();
+
+    /* Bytes changed by reflex bindings stay pending for the next flush. */
+    for (int i = 0; i < handle->device_num; i++) {
+        _store_key(handle->devices[i], data[i], size);
+    }
+
+    return ESP_OK;
+}
@@ -0,0 +1,516 @@
+/**
+ * @file tm1668_priv.h
+ * @brief Private definitions shared by the driver source files.
+ *
+ * Not part of the public API: the structures, command encodings and helpers
+ * in here may change at any time.
+ */
+
+#pragma once
+
+#include "tm1668.h"
+#include "tm1668_cost.h"
+#include "driver/gpio.h"
+#include "esp_rom_sys.h"
+#include "hal/gpio_ll.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "tm1668_latency.h"
+#include "tm1668_proto.h"
+#include "tm1668_reflex.h"
+#include "tm1668_remap.h"
+#include "tm1668_trace.h"
+#include "tm1668_tracepoint.h"
+#include <string.h>
+#ifdef CONFIG_TM1668_WITH_BUS
+#include <sys/queue.h>
+#endif
+
+#ifdef CONFIG_TM1668_WITH_BUS
+/**
+ * @brief Internal bus structure.
+ */
+struct tm1668_bus_t {
+    gpio_num_t clk_num;             /**< Shared CLK GPIO pin */
+    gpio_num_t dio_num;             /**< Shared DIO GPIO pin (open-drain) */
+    SemaphoreHandle_t bus_lock_mux; /**< Mutex for device list access */
+    StaticSemaphore_t bus_lock_buf; /**< Storage for bus_lock_mux */
+    STAILQ_HEAD(tm1668_bus_device_list_head, tm1668_dev_t)
+    device_list;       /**< Devices on this bus, in insertion order */
+    uint64_t stb_mask; /**< Bitmask of STB pins in use on this bus */
+    uint64_t pullup_mask; /**< Pins configured with the internal pull-up */
+    tm1668_timing_t timing; /**< Serial timing, see tm1668_set_timing() */
+    bool is_static;    /**< true if storage is caller-provided */
+    bool defer_gpio;   /**< GPIOs are left to tm1668_bus_init_all() */
+    bool dio_push_pull; /**< DIO is open-drain only during key reads */
+};
+
+/** Dereference the bus handle from a device handle. */
+#define BUS_HANDLE(p) ((p)->bus_handle)
+
+#else
+/** In non-bus mode, the bus handle IS the device handle. */
+typedef tm1668_dev_handle_t tm1668_bus_handle_t;
+
+#define BUS_HANDLE(p) (p)
+#endif
+
+#ifdef CONFIG_TM1668_LATENCY
+/**
+ * @brief Per-device latency tracer state (see tm1668_latency.h).
+ */
+struct tm1668_latency_t {
+    int64_t key_us; /**< esp_timer time of the pending key change */
+    bool pending;   /**< A key change is waiting for its response */
+    bool tagged;    /**< The next display write is the response */
+    tm1668_latency_stats_t stats; /**< Accumulated statistics */
+};
+#endif
+
+/**
+ * @brief Debounced key state, one bit per key (bit 8n + b = key byte n, bit b).
+ *
+ * Bit k of ct0/ct1 together form a 2-bit counter for key k ("vertical
+ * counter"), so every key of the device is debounced by the same few
+ * word-wide operations, see _debounce().
+ */
+struct tm1668_debounce_t {
+    uint64_t state;    /**< Debounced key state */
+    uint64_t ct0;      /**< Counter bit 0 of every key */
+    uint64_t ct1;      /**< Counter bit 1 of every key */
+    uint64_t pressed;  /**< Keys that went down since last read */
+    uint64_t released; /**< Keys that went up since last read */
+};
+
+/**
+ * @brief Internal device structure.
+ */
+struct tm1668_dev_t {
+#ifdef CONFIG_TM1668_WITH_BUS
+    tm1668_bus_handle_t bus_handle;  /**< Owning bus handle (bus mode) */
+    STAILQ_ENTRY(tm1668_dev_t) next; /**< Intrusive bus device list entry */
+    bool is_static;                  /**< true if storage is caller-provided */
+#else
+    gpio_num_t clk_num; /**< CLK GPIO pin (standalone mode) */
+    gpio_num_t dio_num; /**< DIO GPIO pin (standalone mode) */
+    tm1668_timing_t timing; /**< Serial timing (standalone mode) */
+    bool dio_push_pull; /**< DIO is open-drain only during key reads */
+#endif
+    gpio_num_t stb_num;  /**< STB (strobe) GPIO pin */
+    bool address_fixed;  /**< true if device is in fixed-address mode */
+    bool display_on;     /**< Display on/off state (cached) */
+    uint8_t pulse_width; /**< Current pulse width setting (cached) */
+    uint8_t key_size;    /**< Key bytes the chip returns (4 on TM1638) */
+    bool resync;         /**< Chip reset suspected (buf_lock) */
+    portMUX_TYPE buf_lock; /**< Protects display, dirty and key below */
+    uint16_t dirty;        /**< Bit n set: display[n] not yet sent */
+    uint16_t used; /**< Bit n set: display[n] drives segments in this mode */
+    uint8_t seg_hi; /**< SEG9–SEG16 bits driven in this mode (odd bytes) */
+    uint16_t regions; /**< Bit n set: display[n] belongs to a region */
+    uint8_t display[DISPLAY_RAM_SIZE]; /**< Display RAM shadow */
+    uint8_t key[TM1668_KEY_SIZE];      /**< Last key scan result */
+    struct tm1668_debounce_t debounce; /**< Debounced keys */
+    const tm1668_remap_t *remap; /**< Board wiring remap, NULL = none */
+    const tm1668_reflex_t *reflex; /**< Key-to-LED bindings (buf_lock) */
+    size_t reflex_num;             /**< Number of bindings */
+#ifdef CONFIG_TM1668_LATENCY
+    struct tm1668_latency_t latency; /**< Latency tracer (buf_lock) */
+#endif
+};
+
+/**
+ * @brief Global spinlock for protocol-level mutual exclusion.
+ *
+ * While the bus semaphore protects the device list, this spinlock
+ * ensures that the STB → command/data → STB transaction sequence is
+ * not interrupted by another task or ISR.
+ */
+extern portMUX_TYPE tm1668_lock;
+
+/**
+ * @brief Number of urgent transactions waiting for or holding tm1668_lock.
+ *
+ * Key scans, commands and short writes announce themselves here before
+ * taking tm1668_lock. Bulk display writes check it after every byte and,
+ * when it is non-zero, end their burst at that byte boundary and step
+ * aside until the urgent transactions are done (see _display_bulk() and
+ * tm1668_multi_display_auto()).
+ */
+extern volatile uint32_t tm1668_urgent;
+
+/** Auto-increment writes of at most this many bytes are urgent. */
+#define URGENT_WRITE_MAX 2
+
+/** Longest a bulk write steps aside for urgent transactions, in µs. */
+#define URGENT_WAIT_MAX_US 200
+
+/** Take tm1668_lock for an urgent transaction. */
+static inline void _urgent_enter(void)
+{
+    __atomic_add_fetch(&tm1668_urgent, 1, __ATOMIC_ACQ_REL);
+    portENTER_CRITICAL(&tm1668_lock);
+}
+
+/** Release tm1668_lock after an urgent transaction. */
+static inline void _urgent_exit(void)
+{
+    portEXIT_CRITICAL(&tm1668_lock);
+    __atomic_sub_fetch(&tm1668_urgent, 1, __ATOMIC_ACQ_REL);
+}
+
+/**
+ * @brief Wait for the urgent transactions that are queued for the bus.
+ *
+ * A waiter on the other core takes tm1668_lock within a few cycles once it
+ * is free. The wait is bounded because a waiter that was preempted between
+ * announcing itself and taking the lock cannot run on this core anyway.
+ *
+ * @return true if the urgent queue drained, false on timeout.
+ */
+static inline bool _yield_to_urgent(void)
+{
+    for (int us = 0; tm1668_urgent; us++) {
+        if (us >= URGENT_WAIT_MAX_US) {
+            return false;
+        }
+        esp_rom_delay_us(1);
+    }
+    return true;
+}
+
+#ifdef CONFIG_TM1668_TRACE
+/** Record a pin level in the trace ring buffer (see tm1668_trace.h). */
+void tm1668_trace_pin(gpio_num_t pin, tm1668_trace_role_t role,
+                      uint32_t level);
+
+/** Record the same level for every pin in a GPIO0–31 mask. */
+void tm1668_trace_mask(uint32_t mask, tm1668_trace_role_t role,
+                       uint32_t level);
+
+#define TRACE_PIN(pin, role, level) tm1668_trace_pin(pin, role, level)
+#define TRACE_MASK(mask, role, level) tm1668_trace_mask(mask, role, level)
+#else
+#define TRACE_PIN(pin, role, level) ((void)0)
+#define TRACE_MASK(mask, role, level) ((void)0)
+#endif // CONFIG_TM1668_TRACE
+
+#ifdef CONFIG_TM1668_LATENCY
+/** Note a key scan result; caller holds buf_lock, cache not yet updated. */
+void tm1668_latency_key(tm1668_dev_handle_t handle, const uint8_t *data,
+                        size_t size);
+
+/** Note that a display write to the device has reached the bus. */
+void tm1668_latency_sent(tm1668_dev_handle_t handle);
+
+#define LATENCY_KEY(handle, data, size) tm1668_latency_key(handle, data, size)
+#define LATENCY_SENT(handle) tm1668_latency_sent(handle)
+#else
+#define LATENCY_KEY(handle, data, size) ((void)0)
+#define LATENCY_SENT(handle) ((void)0)
+#endif // CONFIG_TM1668_LATENCY
+
+/** Drive the CLK line of a bus (or standalone device). */
+static inline void _set_clk(tm1668_bus_handle_t bus, uint32_t level)
+{
+    gpio_set_level(bus->clk_num, level);
+    TRACE_PIN(bus->clk_num, TM1668_TRACE_CLK, level);
+}
+
+/** Drive (or, with level 1, release) the open-drain DIO line. */
+static inline void _set_dio(tm1668_bus_handle_t bus, uint32_t level)
+{
+    gpio_set_level(bus->dio_num, level);
+    TRACE_PIN(bus->dio_num, TM1668_TRACE_DIO, level);
+}
+
+/** Sample the DIO line. */
+static inline int _get_dio(tm1668_bus_handle_t bus)
+{
+    int level = gpio_get_level(bus->dio_num);
+    TRACE_PIN(bus->dio_num, TM1668_TRACE_DIO, level);
+    return level;
+}
+
+/**
+ * @brief Switch DIO between open-drain and push-pull.
+ *
+ * Only on buses with flags.dio_push_pull, which drive DIO push-pull except
+ * while the chip sends key data. Touches the pad register only, so it is
+ * safe inside critical sections and interrupts.
+ */
+static inline void _set_dio_od(tm1668_bus_handle_t bus, bool od)
+{
+    if (!bus->dio_push_pull) {
+        return;
+    }
+    if (od) {
+        gpio_ll_od_enable(GPIO_LL_GET_HW(GPIO_PORT_0), bus->dio_num);
+    } else {
+        gpio_ll_od_disable(GPIO_LL_GET_HW(GPIO_PORT_0), bus->dio_num);
+    }
+}
+
+/** GPIO mode of DIO outside key reads. */
+static inline gpio_mode_t _dio_mode(tm1668_bus_handle_t bus)
+{
+    return bus->dio_push_pull ? GPIO_MODE_INPUT_OUTPUT
+                              : GPIO_MODE_INPUT_OUTPUT_OD;
+}
+
+/**
+ * @brief Drive the STB line of a device.
+ *
+ * Every STB-low frame starts and ends here, so this is also where the STB
+ * setup (after the falling edge) and hold (before the rising edge) times
+ * are waited out.
+ */
+static inline void _set_stb(tm1668_dev_handle_t handle, uint32_t level)
+{
+    const tm1668_timing_t *timing = &BUS_HANDLE(handle)->timing;
+    if (level && timing->stb_hold_us) {
+        esp_rom_delay_us(timing->stb_hold_us);
+    }
+    gpio_set_level(handle->stb_num, level);
+    TRACE_PIN(handle->stb_num, TM1668_TRACE_STB, level);
+    TM1668_TP_STB(handle->stb_num, level);
+    if (!level && timing->stb_setup_us) {
+        esp_rom_delay_us(timing->stb_setup_us);
+    }
+}
+
+/** Drive the STB lines of every device in a GPIO pin mask. */
+static inline void _set_stb_mask(uint64_t mask, uint32_t level)
+{
+    for (; mask; mask &= mask - 1) {
+        gpio_num_t pin = __builtin_ctzll(mask);
+        gpio_set_level(pin, level);
+        TRACE_PIN(pin, TM1668_TRACE_STB, level);
+        TM1668_TP_STB(pin, level);
+    }
+}
+
+#ifdef CONFIG_TM1668_TIMER_ENGINE
+/** true if the bus timing calls for the engine. */
+static inline bool _is_slow(tm1668_bus_handle_t bus)
+{
+    return bus->timing.write_delay_us >= CONFIG_TM1668_TIMER_ENGINE_MIN_US ||
+           bus->timing.read_delay_us >= CONFIG_TM1668_TIMER_ENGINE_MIN_US;
+}
+
+/**
+ * @brief Claim the timer engine if the bus is slow enough to use it.
+ *
+ * Blocks until the engine is free. Must be called from a task.
+ *
+ * @return true if the caller now owns the engine and must send its frames
+ *         with tm1668_engine_frame(), then call tm1668_engine_unlock();
+ *         false if the bus is bit-banged as usual (engine not taken).
+ */
+bool tm1668_engine_begin(tm1668_bus_handle_t bus);
+
+/** Take the engine unconditionally (e.g. to change a bus timing). */
+void tm1668_engine_lock(void);
+
+/** Release the engine. */
+void tm1668_engine_unlock(void);
+
+/**
+ * @brief Clock one STB frame through the timer engine and wait for it.
+ *
+ * Sends `tx`, then, if `rx_len` is not 0, releases DIO and reads `rx_len`
+ * bytes as after READ_KEY. Caller owns the engine.
+ */
+void tm1668_engine_frame(tm1668_bus_handle_t bus, uint64_t stb_mask,
+                         const uint8_t *tx, size_t tx_len, uint8_t *rx,
+                         size_t rx_len);
+#else
+static inline bool _is_slow(tm1668_bus_handle_t bus)
+{
+    return false;
+}
+static inline bool tm1668_engine_begin(tm1668_bus_handle_t bus)
+{
+    return false;
+}
+static inline void tm1668_engine_lock(void) {}
+static inline void tm1668_engine_unlock(void) {}
+static inline void tm1668_engine_frame(tm1668_bus_handle_t bus,
+                                       uint64_t stb_mask, const uint8_t *tx,
+                                       size_t tx_len, uint8_t *rx,
+                                       size_t rx_len)
+{
+}
+#endif // CONFIG_TM1668_TIMER_ENGINE
+
+/* Default timing: half-clock-cycle delay in microseconds.
+ * Datasheet minimum is 1 us; increase for long traces or clone chips.
+ * Each bus starts with these and may be retuned at run time, see
+ * tm1668_set_timing() and tm1668_calibrate(). */
+#define DELAY_US CONFIG_TM1668_DELAY_US
+
+/* Default settling delay after READ_KEY command before TM1668 drives DIO. */
+#define READ_KEY_DELAY_US CONFIG_TM1668_READ_KEY_DELAY_US
+
+/** Upper bound of every timing value (matches the Kconfig ranges). */
+#define TIMING_MAX_US 1000
+
+/** Timing used until tm1668_set_timing() or tm1668_calibrate(). */
+#define TIMING_DEFAULT                                                         \
+    ((tm1668_timing_t){.write_delay_us = DELAY_US,                             \
+                       .read_delay_us = DELAY_US,                              \
+                       .read_key_delay_us = READ_KEY_DELAY_US})
+
+/** Bitmask of display addresses [address, address + size). */
+#define ADDRESS_RANGE(address, size)                                           \
+    ((uint16_t)((((1UL << (size)) - 1) << (address)) & 0xFFFF))
+
+/** Display addresses driven in TM1668 mode m: GRID1–GRID(m + 4). */
+#define MODE_USED(m) ((uint16_t)((1UL << (((m) + 4) * 2)) - 1))
+/** Inverse of MODE_USED(); only meaningful if used != 0xFFFF. */
+#define USED_MODE(used) ((uint8_t)(__builtin_popcount(used) / 2 - 4))
+/** SEG9–SEG16 bits driven in TM1668 mode m: SEG9, SEG10, SEG12–SEG(14 − m). */
+#define MODE_SEG_HI(m) ((uint8_t)(0x03 | (((1U << (3 - (m))) - 1) << 3)))
+
+/** Chip addresses of the grids touched by the logical addresses in dirty. */
+static inline uint16_t _remap_dirty(const tm1668_remap_t *remap,
+                                    uint16_t dirty)
+{
+    uint16_t out = 0;
+    for (int g = 0; g < TM1668_REMAP_GRIDS; g++) {
+        if (dirty & (3U << (2 * g))) {
+            out |= 3U << (2 * remap->grid[g]);
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Take the next burst off a mask of addresses to send.
+ *
+ * Runs separated by a single clean byte are merged into one burst, see
+ * _display_runs().
+ *
+ * @param[in,out] rest  Addresses still to send; the burst is removed.
+ * @param[out]    first Receives the first address of the burst.
+ * @return Number of addresses in the burst.
+ */
+static inline size_t _next_run(uint32_t *rest, uint8_t *first)
+{
+    uint8_t last = *first = __builtin_ctz(*rest);
+    *rest &= ~((2UL << last) - 1);
+    while (*rest && __builtin_ctz(*rest) <= last + 2) {
+        last = __builtin_ctz(*rest);
+        *rest &= ~((2UL << last) - 1);
+    }
+    return last - *first + 1;
+}
+
+/**
+ * @brief Add the estimated cost of one STB frame to a cost.
+ *
+ * @param[in]     bus    Bus handle (or device handle in non-bus mode).
+ * @param[in]     tx_len Bytes sent, including the command or address byte.
+ * @param[in]     rx_len Key bytes read after a READ_KEY command, or 0.
+ * @param[in,out] cost   Cost to add to.
+ */
+void tm1668_cost_frame(tm1668_bus_handle_t bus, size_t tx_len, size_t rx_len,
+                       tm1668_cost_t *cost);
+
+/** Store display bytes in the shadow buffer as already sent (write-through). */
+static inline void _store(tm1668_dev_handle_t handle, uint8_t address,
+                          const uint8_t *data, size_t size)
+{
+    portENTER_CRITICAL(&handle->buf_lock);
+    memcpy(&handle->display[address], data, size);
+    handle->dirty &= ~ADDRESS_RANGE(address, size);
+    portEXIT_CRITICAL(&handle->buf_lock);
+}
+
+/**
+ * @brief Feed the key cache to the debouncer. Caller holds buf_lock.
+ *
+ * A key's counter is held at 3 while its raw bit agrees with the debounced
+ * state and counts down on each scan that disagrees; the state flips when
+ * it wraps, i.e. after TM1668_DEBOUNCE_SCANS disagreeing scans in a row.
+ */
+static inline void _debounce(tm1668_dev_handle_t handle)
+{
+    struct tm1668_debounce_t *db = &handle->debounce;
+    uint64_t raw = 0;
+    for (int n = 0; n < TM1668_KEY_SIZE; n++) {
+        raw |= (uint64_t)handle->key[n] << (8 * n);
+    }
+    uint64_t change = db->state ^ raw;
+    db->ct0 = ~(db->ct0 & change);
+    db->ct1 = db->ct0 ^ (db->ct1 & change);
+    change &= db->ct0 & db->ct1;
+    db->state ^= change;
+    db->pressed |= db->state & change;
+    db->released |= ~db->state & change;
+}
+
+/** Key bytes every chip returns (TM1638 has 4); checked for plausibility by
+ *  CONFIG_TM1668_KEY_RESYNC and tm1668_calibrate(). */
+#define KEY_CHECK_SIZE 4
+/** Key bits that are 0 on every TM1668 and TM1638 key byte; a DIO left to
+ *  the pull-up or sampled too early reads 1 there. */
+#define KEY_CHECK_MASK 0x80
+
+/**
+ * @brief Apply the reflex bindings to the shadow. Caller holds buf_lock.
+ *
+ * @return Bitmask of the display addresses changed (and marked dirty).
+ */
+static inline uint16_t _reflex(tm1668_dev_handle_t handle)
+{
+    uint16_t changed = 0;
+    for (size_t n = 0; n < handle->reflex_num; n++) {
+        const tm1668_reflex_t *r = &handle->reflex[n];
+        uint8_t mask = 1U << r->bit;
+        uint8_t old = handle->display[r->address];
+        uint8_t value = ((handle->key[r->key_byte] >> r->key_bit) & 1)
+                            ? old | mask
+                            : old & ~mask;
+        if (value != old) {
+            handle->display[r->address] = value;
+            changed |= 1U << r->address;
+        }
+    }
+    handle->dirty |= changed;
+    return changed;
+}
+
+/**
+ * @brief Store a key scan result in the device cache and debounce it.
+ *
+ * With CONFIG_TM1668_KEY_RESYNC, an implausible scan is dropped and the
+ * device scheduled for resync instead. Reflex bindings are applied to the
+ * shadow; the caller sends the returned addresses.
+ *
+ * @return Bitmask of the display addresses changed by reflex bindings.
+ */
+static inline uint16_t _store_key(tm1668_dev_handle_t handle,
+                                  const uint8_t *data, size_t size)
+{
+    /* Bytes past the chip's key data are bus noise. */
+    if (size > handle->key_size) {
+        size = handle->key_size;
+    }
+    portENTER_CRITICAL(&handle->buf_lock);
+#ifdef CONFIG_TM1668_KEY_RESYNC
+    /* Bit 7 of key bytes 0–3 never reads 1 from a powered chip. */
+    for (int n = 0; n < size && n < KEY_CHECK_SIZE; n++) {
+        if (data[n] & KEY_CHECK_MASK) {
+            handle->resync = true;
+            portEXIT_CRITICAL(&handle->buf_lock);
+            return 0;
+        }
+    }
+#endif
+    LATENCY_KEY(handle, data, size);
+    memcpy(handle->key, data, size);
+    _debounce(handle);
+    uint16_t changed = _reflex(handle);
+    portEXIT_CRITICAL(&handle->buf_lock);
+    return changed;
+}
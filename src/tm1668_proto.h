@@ -0,0 +1,70 @@
+/**
+ * @file tm1668_proto.h
+ * @brief TM1668 / TM1638 serial protocol encoding.
+ *
+ * Plain C with no platform dependencies, shared by the ESP-IDF driver and
+ * the Linux backend in port/linux. Not part of the public API.
+ */
+
+#pragma once
+
+/** Size of the display register address space (TM1638: 16, TM1668: 14). */
+#define DISPLAY_RAM_SIZE 0x10
+
+/** Longest key scan (TM1668: 5 bytes, TM1638: 4). */
+#define KEY_SIZE_MAX 5
+
+/*
+ * Command byte encoding (TM1668 / TM1638 datasheet).
+ *
+ *   B7 B6 B5 B4 B3 B2 B1 B0
+ *   ─────────────────────────
+ *   0  0  —  —  —  —  —  —   Display mode setting command
+ *   0  1  —  —  —  —  —  —   Data command (0: fixed, 1: auto-increment)
+ *   1  0  —  —  —  —  —  —   Display control (on/off + pulse width)
+ *   1  1  —  —  —  —  —  —   Address setting (upper 4 bits = 0xC0)
+ */
+
+/** Display mode command prefix: 0b00xxxxxx. */
+#define MODE 0x00
+/** Data write mode: auto-increment address after each byte. */
+#define ADDRESS_INCREMENT 0x40
+/** Data write mode: write to fixed address (no auto-increment). */
+#define ADDRESS_FIXED 0x44
+/** Display register address command prefix: 0b11xxxxxx. */
+#define DISPLAY_ADDRESS 0xC0
+/** Mask for the 4-bit address field. */
+#define ADDRESS_MASK 0xF
+/** Read key scan data command. */
+#define READ_KEY 0x42
+/** Mask for the 2-bit mode field. */
+#define MODE_MASK 0x3
+/** Display control command prefix: 0b1000xxxx. */
+#define DISPLAY_CONTROL 0x80
+/** Mask for the 3-bit pulse width field. */
+#define PULSE_WIDTH_MASK 0x7
+/** Bit 3 = display on/off in the display control command. */
+#define DISPLAY_BIT 3
+
+/** Mask for the command group bits (B7..B6). */
+#define COMMAND_GROUP_MASK 0xC0
+/** Data command bit 2: fixed address. */
+#define ADDRESS_FIXED_BIT 0x04
+
+/*
+ * Complete command bytes. Every frame starts with one of these, sent with
+ * STB low; bytes go out LSB first and DIO is latched on the rising CLK
+ * edge. Display data follows an address command in the same frame, key
+ * data follows READ_KEY once DIO is released.
+ */
+
+/** Display mode setting command for a mode (TM1668 only). */
+#define MODE_COMMAND(mode) (MODE | (MODE_MASK & (mode)))
+/** Data command selecting fixed-address or auto-increment writes. */
+#define DATA_COMMAND(fixed) ((fixed) ? ADDRESS_FIXED : ADDRESS_INCREMENT)
+/** Address setting command for a display register. */
+#define ADDRESS_COMMAND(address) (DISPLAY_ADDRESS | (ADDRESS_MASK & (address)))
+/** Display control command: display on/off and pulse width. */
+#define DISPLAY_CONTROL_COMMAND(on, pulse_width)                              \
+    (DISPLAY_CONTROL | ((on) ? 1 << DISPLAY_BIT : 0) |                        \
+     (PULSE_WIDTH_MASK & (pulse_width)))
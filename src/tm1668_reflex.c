@@ -0,0 +1,40 @@
+/**
+ * @file tm1668_reflex.c
+ * @brief Key-to-LED reflex bindings executed in the key scan path.
+ *
+ * Only the table is managed here. The bindings run in _store_key(), under
+ * the buffer lock that already guards the key cache and the shadow, and
+ * the scanning functions send the bytes they changed.
+ */
+
+#include "tm1668_reflex.h"
+#include "esp_check.h"
+#include "tm1668_priv.h"
+
+static const char TAG[] = "tm1668_reflex";
+
+esp_err_t tm1668_set_reflex(tm1668_dev_handle_t handle,
+                            const tm1668_reflex_t *table, size_t count)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+    if (!table) {
+        count = 0;
+    }
+    ESP_RETURN_ON_FALSE(count <= TM1668_REFLEX_MAX, ESP_ERR_INVALID_ARG, TAG,
+                        "too many bindings");
+    for (size_t n = 0; n < count; n++) {
+        const tm1668_reflex_t *r = &table[n];
+        ESP_RETURN_ON_FALSE(r->key_byte < TM1668_KEY_SIZE && r->key_bit < 8 &&
+                                r->address < DISPLAY_RAM_SIZE && r->bit < 8,
+                            ESP_ERR_INVALID_ARG, TAG, "invalid binding %u",
+                            (unsigned)n);
+    }
+
+    portENTER_CRITICAL(&handle->buf_lock);
+    handle->reflex = table;
+    handle->reflex_num = count;
+    portEXIT_CRITICAL(&handle->buf_lock);
+
+    return ESP_OK;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file tm1668_region.c
+ * @brief Display regions owned by different tasks, sent by one merged flush.
+ *
+ * A region only adds bounds to tm1668_display_buffer(): the shadow and its
+ * dirty mask already let several writers stage independently, and the
+ * flush already merges whatever is dirty. The device keeps a mask of the
+ * addresses given to regions so that no two regions overlap.
+ */
+
+#include "tm1668_region.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "tm1668_priv.h"
+
+static const char TAG[] = "tm1668_region";
+
+/**
+ * @brief Internal region structure.
+ */
+struct tm1668_region_t {
+    tm1668_dev_handle_t device; /**< Owning device */
+    const char *name;           /**< Name for log messages */
+    uint8_t address;            /**< First display address */
+    uint8_t size;               /**< Number of addresses */
+};
+
+esp_err_t tm1668_new_region(tm1668_dev_handle_t device,
+                            const tm1668_region_config_t *config,
+                            tm1668_region_handle_t *ret_region)
+{
+    ESP_RETURN_ON_FALSE(device && config && ret_region, ESP_ERR_INVALID_ARG,
+                        TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(config->size && config->address < DISPLAY_RAM_SIZE &&
+                            config->address + config->size <= DISPLAY_RAM_SIZE,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid span");
+
+    tm1668_region_handle_t region = calloc(1, sizeof(struct tm1668_region_t));
+    ESP_RETURN_ON_FALSE(region, ESP_ERR_NO_MEM, TAG, "no memory for region");
+    region->device = device;
+    region->name = config->name ? config->name : "";
+    region->address = config->address;
+    region->size = config->size;
+
+    uint16_t span = ADDRESS_RANGE(config->address, config->size);
+    portENTER_CRITICAL(&device->buf_lock);
+    bool overlap = device->regions & span;
+    if (!overlap) {
+        device->regions |= span;
+    }
+    portEXIT_CRITICAL(&device->buf_lock);
+    if (overlap) {
+        free(region);
+        ESP_LOGE(TAG, "region \"%s\" overlaps another region",
+                 config->name ? config->name : "");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    *ret_region = region;
+    return ESP_OK;
+}
+
+esp_err_t tm1668_del_region(tm1668_region_handle_t region)
+{
+    ESP_RETURN_ON_FALSE(region, ESP_ERR_INVALID_ARG, TAG, "invalid region");
+
+    tm1668_dev_handle_t device = region->device;
+    portENTER_CRITICAL(&device->buf_lock);
+    device->regions &= ~ADDRESS_RANGE(region->address, region->size);
+    portEXIT_CRITICAL(&device->buf_lock);
+    free(region);
+    return ESP_OK;
+}
+
+esp_err_t tm1668_region_write(tm1668_region_handle_t region, uint8_t offset,
+                              const uint8_t *data, size_t size)
+{
+    ESP_RETURN_ON_FALSE(region && data, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid argument");
+    ESP_RETURN_ON_FALSE(offset + size <= region->size, ESP_ERR_INVALID_ARG,
+                        TAG, "write outside region \"%s\"", region->name);
+
+    return tm1668_display_buffer(region->device, region->address + offset,
+                                 data, size);
+}
+
+esp_err_t tm1668_region_fill(tm1668_region_handle_t region, uint8_t value)
+{
+    ESP_RETURN_ON_FALSE(region, ESP_ERR_INVALID_ARG, TAG, "invalid region");
+
+    uint8_t buf[DISPLAY_RAM_SIZE];
+    memset(buf, value, region->size);
+    return tm1668_display_buffer(region->device, region->address, buf,
+                                 region->size);
+}
@@ -0,0 +1,74 @@
+/**
+ * @file tm1668_remap.c
+ * @brief Board wiring remap: logical segments and grids to chip lines.
+ *
+ * Since the segment permutation is the same on every grid, the 16-bit row
+ * of a grid remaps as the OR of its two bytes remapped separately. Each
+ * table holds that partial result for all 256 values of one byte, built
+ * from the single-bit entries: the entry of v is the entry of v without its
+ * lowest bit, OR the entry of that bit.
+ */
+
+#include "tm1668_remap.h"
+#include "esp_check.h"
+#include "tm1668_priv.h"
+
+static const char TAG[] = "tm1668_remap";
+
+esp_err_t tm1668_remap_build(const tm1668_board_map_t *board,
+                             tm1668_remap_t *remap)
+{
+    ESP_RETURN_ON_FALSE(board && remap, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid argument");
+
+    uint32_t seen = 0;
+    for (int s = 0; s < TM1668_REMAP_SEGS; s++) {
+        ESP_RETURN_ON_FALSE(board->seg[s] < TM1668_REMAP_SEGS &&
+                                !(seen & (1UL << board->seg[s])),
+                            ESP_ERR_INVALID_ARG, TAG, "invalid segment %d",
+                            s);
+        seen |= 1UL << board->seg[s];
+    }
+    seen = 0;
+    for (int g = 0; g < TM1668_REMAP_GRIDS; g++) {
+        ESP_RETURN_ON_FALSE(board->grid[g] < TM1668_REMAP_GRIDS &&
+                                !(seen & (1UL << board->grid[g])),
+                            ESP_ERR_INVALID_ARG, TAG, "invalid grid %d", g);
+        seen |= 1UL << board->grid[g];
+    }
+
+    remap->lo[0] = 0;
+    remap->hi[0] = 0;
+    for (int v = 1; v < 256; v++) {
+        int b = __builtin_ctz(v);
+        remap->lo[v] = remap->lo[v & (v - 1)] | (1U << board->seg[b]);
+        remap->hi[v] = remap->hi[v & (v - 1)] | (1U << board->seg[b + 8]);
+    }
+    memcpy(remap->grid, board->grid, sizeof(remap->grid));
+
+    return ESP_OK;
+}
+
+void tm1668_remap_frame(const tm1668_remap_t *remap, const uint8_t *logical,
+                        uint8_t *physical)
+{
+    for (int g = 0; g < TM1668_REMAP_GRIDS; g++) {
+        uint16_t row = remap->lo[logical[2 * g]] | remap->hi[logical[2 * g + 1]];
+        physical[2 * remap->grid[g]] = row;
+        physical[2 * remap->grid[g] + 1] = row >> 8;
+    }
+}
+
+esp_err_t tm1668_set_remap(tm1668_dev_handle_t handle,
+                           const tm1668_remap_t *remap)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid device handle");
+
+    portENTER_CRITICAL(&handle->buf_lock);
+    handle->remap = remap;
+    handle->dirty = 0xFFFF;
+    portEXIT_CRITICAL(&handle->buf_lock);
+
+    return ESP_OK;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file tm1668_seg7.c
+ * @brief Number formatting straight into 7-segment codes.
+ *
+ * Binary to BCD uses double dabble: the value is shifted into a packed BCD
+ * accumulator one bit at a time, and before each shift every BCD digit
+ * that is 5 or more gets 3 added. All ten digits are adjusted at once:
+ * adding 3 to a digit sets its bit 3 exactly when the digit is 5 or more,
+ * and that bit, shifted down, builds the "+3" mask. A digit plus 3 never
+ * exceeds 12, so no carry crosses a digit boundary.
+ */
+
+#include "tm1668_seg7.h"
+#include "esp_check.h"
+
+static const char TAG[] = "tm1668_seg7";
+
+const uint8_t tm1668_seg7_digits[16] = {
+    0x3F, /* 0 */
+    0x06, /* 1 */
+    0x5B, /* 2 */
+    0x4F, /* 3 */
+    0x66, /* 4 */
+    0x6D, /* 5 */
+    0x7D, /* 6 */
+    0x07, /* 7 */
+    0x7F, /* 8 */
+    0x6F, /* 9 */
+    0x77, /* A */
+    0x7C, /* b */
+    0x39, /* C */
+    0x5E, /* d */
+    0x79, /* E */
+    0x71, /* F */
+};
+
+/** Largest width: one digit per nibble of the 64-bit digit accumulator. */
+#define SEG7_MAX_WIDTH 16
+
+/** Convert to packed BCD, one decimal digit per nibble (units lowest). */
+static uint64_t _bcd(uint32_t value)
+{
+    uint64_t bcd = 0;
+    if (!value) {
+        return 0;
+    }
+    /* Leading zero bits would only shift zeros around: skip them. */
+    for (int b = 31 - __builtin_clz(value); b >= 0; b--) {
+        uint64_t five = (bcd + 0x3333333333ULL) & 0x8888888888ULL;
+        bcd += (five >> 2) | (five >> 3);
+        bcd = (bcd << 1) | ((value >> b) & 1);
+    }
+    return bcd;
+}
+
+/**
+ * @brief Lay out packed digits as segment codes.
+ *
+ * @param[in]  fmt    Output format (validated).
+ * @param[in]  digits One digit per nibble, units lowest.
+ * @param[in]  neg    Prepend a minus sign.
+ * @param[out] out    Output buffer.
+ * @return ESP_OK, or ESP_ERR_INVALID_SIZE if the number does not fit.
+ */
+static esp_err_t _render(const tm1668_seg7_format_t *fmt, uint64_t digits,
+                         bool neg, uint8_t *out)
+{
+    size_t width = fmt->width;
+    size_t stride = fmt->stride ? fmt->stride : 1;
+    size_t used = digits ? (64 - __builtin_clzll(digits) + 3) / 4 : 1;
+    size_t shown = used > fmt->point ? used : fmt->point + 1;
+    if (fmt->zero_pad && shown + neg < width) {
+        shown = width - neg;
+    }
+
+    if (shown + neg > width) {
+        for (size_t i = 0; i < width; i++) {
+            out[i * stride] = TM1668_SEG7_MINUS;
+        }
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    for (size_t i = 0; i < width; i++) {
+        size_t k = width - 1 - i; /* digit position from the right */
+        uint8_t code = TM1668_SEG7_BLANK;
+        if (k < shown) {
+            code = tm1668_seg7_digits[(digits >> (4 * k)) & 0xF];
+            if (fmt->point && k == fmt->point) {
+                code |= TM1668_SEG7_DP;
+            }
+        } else if (neg && k == shown) {
+            code = TM1668_SEG7_MINUS;
+        }
+        out[i * stride] = code;
+    }
+    return ESP_OK;
+}
+
+/** Shared argument checks. */
+static esp_err_t _check(const tm1668_seg7_format_t *fmt, const uint8_t *out)
+{
+    ESP_RETURN_ON_FALSE(fmt && out, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid argument");
+    ESP_RETURN_ON_FALSE(fmt->width > 0 && fmt->width <= SEG7_MAX_WIDTH,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid width");
+    ESP_RETURN_ON_FALSE(fmt->point < fmt->width, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid point");
+    return ESP_OK;
+}
+
+esp_err_t tm1668_seg7_dec(const tm1668_seg7_format_t *fmt, int32_t value,
+                          uint8_t *out)
+{
+    ESP_RETURN_ON_ERROR(_check(fmt, out), TAG, "invalid format");
+
+    /* Unsigned negation also covers INT32_MIN. */
+    bool neg = value < 0;
+    uint32_t magnitude = neg ? 0U - (uint32_t)value : (uint32_t)value;
+    return _render(fmt, _bcd(magnitude), neg, out);
+}
+
+esp_err_t tm1668_seg7_hex(const tm1668_seg7_format_t *fmt, uint32_t value,
+                          uint8_t *out)
+{
+    ESP_RETURN_ON_ERROR(_check(fmt, out), TAG, "invalid format");
+
+    return _render(fmt, value, false, out);
+}
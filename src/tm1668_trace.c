@@ -0,0 +1,142 @@
+/**
+ * @file tm1668_trace.c
+ * @brief Bus transition trace capture (CONFIG_TM1668_TRACE).
+ *
+ * The recorder is called from inside the driver's critical sections, so it
+ * only takes its own spinlock and never blocks. The last level of every
+ * pin is remembered in a 64-bit mask so that repeated writes of the same
+ * level (e.g. releasing an already released DIO) cost one compare and are
+ * not stored.
+ */
+
+#include "tm1668_trace.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "tm1668_priv.h"
+#include <stdio.h>
+
+#ifdef CONFIG_TM1668_TRACE
+
+#define TRACE_SIZE CONFIG_TM1668_TRACE_BUFFER_SIZE
+
+static portMUX_TYPE trace_lock = portMUX_INITIALIZER_UNLOCKED;
+static tm1668_trace_event_t trace_buf[TRACE_SIZE];
+static size_t trace_head;  /**< Next slot to write */
+static size_t trace_count; /**< Valid events */
+static uint32_t trace_dropped;
+static uint64_t trace_known; /**< Pins with a recorded level */
+static uint64_t trace_level; /**< Last recorded level per pin */
+
+/** Append one event; caller holds trace_lock. */
+static inline void _record(uint32_t cycles, gpio_num_t pin,
+                           tm1668_trace_role_t role, uint32_t level)
+{
+    uint64_t bit = 1ULL << pin;
+    if ((trace_known & bit) && !(trace_level & bit) == !level) {
+        return;
+    }
+    trace_known |= bit;
+    trace_level = level ? trace_level | bit : trace_level & ~bit;
+
+    tm1668_trace_event_t *e = &trace_buf[trace_head];
+    e->cycles = cycles;
+    e->pin = pin;
+    e->role = role;
+    e->level = level ? 1 : 0;
+    e->reserved = 0;
+    trace_head = (trace_head + 1) % TRACE_SIZE;
+    if (trace_count < TRACE_SIZE) {
+        trace_count++;
+    } else {
+        trace_dropped++;
+    }
+}
+
+void tm1668_trace_pin(gpio_num_t pin, tm1668_trace_role_t role,
+                      uint32_t level)
+{
+    uint32_t cycles = esp_cpu_get_cycle_count();
+    portENTER_CRITICAL_SAFE(&trace_lock);
+    _record(cycles, pin, role, level);
+    portEXIT_CRITICAL_SAFE(&trace_lock);
+}
+
+void tm1668_trace_mask(uint32_t mask, tm1668_trace_role_t role,
+                       uint32_t level)
+{
+    /* One timestamp: the bits of a mask change with a single register write. */
+    uint32_t cycles = esp_cpu_get_cycle_count();
+    portENTER_CRITICAL_SAFE(&trace_lock);
+    while (mask) {
+        int pin = __builtin_ctz(mask);
+        _record(cycles, (gpio_num_t)pin, role, level);
+        mask &= mask - 1;
+    }
+    portEXIT_CRITICAL_SAFE(&trace_lock);
+}
+
+size_t tm1668_trace_read(tm1668_trace_event_t *events, size_t max)
+{
+    if (!events) {
+        return 0;
+    }
+    portENTER_CRITICAL(&trace_lock);
+    size_t n = trace_count < max ? trace_count : max;
+    size_t tail = (trace_head + TRACE_SIZE - trace_count) % TRACE_SIZE;
+    for (size_t i = 0; i < n; i++) {
+        events[i] = trace_buf[(tail + i) % TRACE_SIZE];
+    }
+    trace_count -= n;
+    portEXIT_CRITICAL(&trace_lock);
+    return n;
+}
+
+void tm1668_trace_clear(void)
+{
+    portENTER_CRITICAL(&trace_lock);
+    trace_count = 0;
+    trace_dropped = 0;
+    trace_known = 0;
+    portEXIT_CRITICAL(&trace_lock);
+}
+
+uint32_t tm1668_trace_dropped(void)
+{
+    portENTER_CRITICAL(&trace_lock);
+    uint32_t dropped = trace_dropped;
+    portEXIT_CRITICAL(&trace_lock);
+    return dropped;
+}
+
+void tm1668_trace_dump(void)
+{
+    /* Printed in small batches so that the lock is never held across I/O. */
+    tm1668_trace_event_t batch[16];
+    size_t n;
+
+    printf("TM1668TRACE begin cpu_hz=%lu\n",
+           (unsigned long)esp_rom_get_cpu_ticks_per_us() * 1000000UL);
+    while ((n = tm1668_trace_read(batch, sizeof(batch) / sizeof(batch[0])))) {
+        for (size_t i = 0; i < n; i++) {
+            printf("TM1668TRACE %lu %u %u %u\n", (unsigned long)batch[i].cycles,
+                   batch[i].pin, batch[i].role, batch[i].level);
+        }
+    }
+    printf("TM1668TRACE end dropped=%lu\n",
+           (unsigned long)tm1668_trace_dropped());
+}
+
+#else // CONFIG_TM1668_TRACE
+
+size_t tm1668_trace_read(tm1668_trace_event_t *events, size_t max)
+{
+    return 0;
+}
+
+void tm1668_trace_clear(void) {}
+
+uint32_t tm1668_trace_dropped(void) { return 0; }
+
+void tm1668_trace_dump(void) {}
+
+#endif // CONFIG_TM1668_TRACE
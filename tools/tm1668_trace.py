@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""Convert a TM1668 bus trace dump to a VCD waveform and a command log.
+
+The input is console output containing the lines printed by
+tm1668_trace_dump() (other lines are ignored, so a raw `idf.py monitor`
+log works):
+
+    TM1668TRACE begin cpu_hz=240000000
+    TM1668TRACE <cycles> <pin> <role> <level>
+    ...
+    TM1668TRACE end dropped=0
+
+Usage:
+
+    python tm1668_trace.py capture.log -o capture.vcd [-l capture.txt]
+
+The VCD file has one wire per traced pin (clk18, dio19, stb23, ...) and
+opens in GTKWave. The command log lists every STB-low frame with its start
+time, duration, clock count and decoded bytes, plus the idle gap since the
+previous frame, so wasted clock periods and oversized gaps stand out.
+"""
+
+import argparse
+import re
+import sys
+
+ROLES = {0: "clk", 1: "dio", 2: "stb"}
+LINE = re.compile(r"TM1668TRACE\s+(.*)$")
+
+
+def parse(lines):
+    """Return (cpu_hz, dropped, events) with unwrapped 64-bit cycle counts."""
+    cpu_hz = 240_000_000
+    dropped = 0
+    events = []
+    last = None
+    high = 0
+    for line in lines:
+        m = LINE.search(line)
+        if not m:
+            continue
+        fields = m.group(1).split()
+        if fields[0] == "begin":
+            cpu_hz = int(fields[1].split("=")[1])
+            continue
+        if fields[0] == "end":
+            dropped += int(fields[1].split("=")[1])
+            continue
+        cycles, pin, role, level = (int(f) for f in fields[:4])
+        if last is not None and cycles < last:
+            high += 1 << 32  # 32-bit cycle counter wrapped
+        last = cycles
+        events.append((high + cycles, pin, role, level))
+    return cpu_hz, dropped, events
+
+
+def write_vcd(out, cpu_hz, events):
+    pins = sorted({(role, pin) for _, pin, role, _ in events})
+    ids = {}
+    out.write("$timescale 1ns $end\n$scope module tm1668 $end\n")
+    for n, (role, pin) in enumerate(pins):
+        ident = chr(33 + n)
+        ids[pin] = ident
+        out.write(f"$var wire 1 {ident} {ROLES[role]}{pin} $end\n")
+    out.write("$upscope $end\n$enddefinitions $end\n")
+    if not events:
+        return
+    t0 = events[0][0]
+    current = None
+    for cycles, pin, _, level in events:
+        t = (cycles - t0) * 1_000_000_000 // cpu_hz
+        if t != current:
+            out.write(f"#{t}\n")
+            current = t
+        out.write(f"{level}{ids[pin]}\n")
+
+
+def describe(data):
+    """Decode the bytes of one STB frame."""
+    if not data:
+        return "(empty frame)"
+    cmd = data[0]
+    group = cmd & 0xC0
+    hexdata = " ".join(f"{b:02X}" for b in data[1:])
+    if group == 0x00:
+        modes = ("4x13", "5x12", "6x11", "7x10")
+        return f"{cmd:02X} MODE {modes[cmd & 0x03]}"
+    if group == 0x40:
+        if cmd & 0x02:
+            return f"{cmd:02X} READ_KEY -> {hexdata}"
+        kind = "fixed" if cmd & 0x04 else "auto-increment"
+        return f"{cmd:02X} DATA write {kind}"
+    if group == 0xC0:
+        return f"{cmd:02X} ADDRESS {cmd & 0x0F:#04x}: {hexdata}"
+    on = "on" if cmd & 0x08 else "off"
+    return f"{cmd:02X} DISPLAY {on} pulse={cmd & 0x07}"
+
+
+def decode(cpu_hz, events):
+    """Yield (start, end, stb_pin, clocks, {dio_pin: bytes}) per frame.
+
+    Written bits are taken as the DIO level at the CLK rising edge, when the
+    chip latches them. After a READ_KEY command the chip shifts its data out
+    on the falling edge and the driver samples DIO after the rising edge, so
+    read bits are taken as the DIO level just before the next falling edge
+    (or STB rising edge), which includes the driver's recorded sample.
+    """
+    level = {}
+    role_of = {}
+    frame = None
+    for cycles, pin, role, value in events:
+        role_of[pin] = role
+        if role == 2 and value == 0 and frame is None:
+            frame = {"start": cycles, "stb": pin, "clocks": 0,
+                     "pending": False, "reading": False, "bits": {}}
+        elif role == 0 and frame is not None:
+            if value == 0 and frame["pending"]:
+                _take_bit(frame, level, role_of)
+            if value == 1:
+                frame["clocks"] += 1
+                if frame["reading"]:
+                    frame["pending"] = True
+                else:
+                    _take_bit(frame, level, role_of)
+                    if frame["clocks"] == 8:
+                        first = _bytes(frame["bits"])
+                        frame["reading"] = any(
+                            b and b[0] & 0xC2 == 0x42 for b in first.values())
+        elif role == 2 and value == 1 and frame is not None:
+            if frame["pending"]:
+                _take_bit(frame, level, role_of)
+            yield (frame["start"], cycles, frame["stb"], frame["clocks"],
+                   _bytes(frame["bits"]))
+            frame = None
+        level[pin] = value
+
+
+def _take_bit(frame, level, role_of):
+    frame["pending"] = False
+    for pin, role in role_of.items():
+        if role == 1:
+            frame["bits"].setdefault(pin, []).append(level.get(pin, 1))
+
+
+def _bytes(bits):
+    out = {}
+    for pin, stream in bits.items():
+        out[pin] = [sum(bit << b for b, bit in enumerate(stream[n:n + 8]))
+                    for n in range(0, len(stream) - 7, 8)]
+    return out
+
+
+def write_log(out, cpu_hz, dropped, events):
+    if dropped:
+        out.write(f"warning: {dropped} events were dropped (buffer full)\n")
+    if not events:
+        out.write("no events\n")
+        return
+    us = 1_000_000 / cpu_hz
+    t0 = events[0][0]
+    last_end = None
+    for start, end, stb, clocks, data in decode(cpu_hz, events):
+        gap = f"+{(start - last_end) * us:8.2f}" if last_end else " " * 9
+        last_end = end
+        for dio, value in sorted(data.items()):
+            out.write(f"{(start - t0) * us:10.2f} us {gap} "
+                      f"stb{stb} dio{dio} "
+                      f"[{(end - start) * us:7.2f} us, {clocks:3d} clk] "
+                      f"{describe(value)}\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", nargs="?", type=argparse.FileType("r"),
+                        default=sys.stdin, help="console log (default stdin)")
+    parser.add_argument("-o", "--vcd", required=True, help="VCD output file")
+    parser.add_argument("-l", "--log", help="command log (default stdout)")
+    args = parser.parse_args()
+
+    cpu_hz, dropped, events = parse(args.input)
+    with open(args.vcd, "w") as out:
+        write_vcd(out, cpu_hz, events)
+    if args.log:
+        with open(args.log, "w") as out:
+            write_log(out, cpu_hz, dropped, events)
+    else:
+        write_log(sys.stdout, cpu_hz, dropped, events)
+
+
+if __name__ == "__main__":
+    main()